@@ -3,6 +3,7 @@
 #include <cstdlib>
 #include <cmath>
 #include "Shader.h"
+#include "GLState.h"
 
 AsteroidBelt::AsteroidBelt(int numAsteroids, float innerRadius, float outerRadius)
     : asteroidCount(numAsteroids)
@@ -35,7 +36,6 @@ AsteroidBelt::AsteroidBelt(int numAsteroids, float innerRadius, float outerRadiu
 void AsteroidBelt::render(const Shader &shader)
 {
     shader.use(); // Use the asteroid particle shader
-    glBindVertexArray(VAO);
+    GLState::bindVertexArray(VAO);
     glDrawArrays(GL_POINTS, 0, asteroidCount);
-    glBindVertexArray(0);
 }
\ No newline at end of file
@@ -11,6 +11,9 @@ public:
     AsteroidBelt(int numAsteroids, float innerRadius, float outerRadius);
     void render(const Shader &shader);
 
+    const std::vector<glm::vec3> &getPositions() const { return positions; }
+    float particleRadius() const { return 0.03f; } // collision size of one particle
+
 private:
     std::vector<glm::vec3> positions;
     unsigned int VAO, VBO;
@@ -1,5 +1,6 @@
 #include "Camera.h"
 #include <algorithm>
+#include <cmath>
 
 Camera::Camera(glm::vec3 position)
     : Front(glm::vec3(0.0f, 0.0f, -1.0f)),
@@ -23,7 +24,31 @@ glm::mat4 Camera::GetViewMatrix()
 
 glm::mat4 Camera::getProjectionMatrix() const
 {
-    return glm::perspective(glm::radians(Zoom), aspectRatio, nearPlane, farPlane);
+    if (depthMode != DEPTH_REVERSED)
+        return glm::perspective(glm::radians(Zoom), aspectRatio, nearPlane, farPlane);
+
+    // Clip-space depth [0, 1]: z_clip = near, w_clip = -z_eye, so depth = near / distance,
+    // 1 at the near plane falling towards 0 at infinity, where float precision is densest
+    float f = 1.0f / tan(glm::radians(Zoom) * 0.5f);
+    glm::mat4 projection(0.0f);
+    projection[0][0] = f / aspectRatio;
+    projection[1][1] = f;
+    projection[2][3] = -1.0f;
+    projection[3][2] = nearPlane;
+    return projection;
+}
+
+glm::vec4 Camera::getDepthParams() const
+{
+    // Log depth maps w = farPlane to NDC 1: log2(1 + w) * coef - 1
+    float logCoefficient = 2.0f / std::log2(farPlane + 1.0f);
+    float farDepth = depthMode == DEPTH_REVERSED ? 0.0f : 1.0f;
+    return glm::vec4((float)depthMode, logCoefficient, farDepth, 0.0f);
+}
+
+float Camera::getPixelScale(int viewportHeight) const
+{
+    return (float)viewportHeight / (2.0f * tan(glm::radians(Zoom) * 0.5f));
 }
 
 void Camera::ProcessKeyboard(Camera_Movement direction, float deltaTime)
@@ -94,6 +119,12 @@ void Camera::ProcessMouseScroll(float yoffset)
         Zoom = 45.0f;
 }
 
+void Camera::ScaleSpeedToClearance(float surfaceDistance)
+{
+    float scale = std::max(surfaceDistance, 0.0f) / SPEED_REFERENCE_DISTANCE;
+    MovementSpeed = SPEED * std::clamp(scale, SPEED_SCALE_MIN, SPEED_SCALE_MAX);
+}
+
 void Camera::SetTrackingMode(bool enabled, glm::vec3 target)
 {
     trackingMode = enabled;
@@ -15,6 +15,21 @@ enum Camera_Movement
     DOWN
 };
 
+// How scene depth is stored. Reversed-Z (float depth, near = 1, no far plane)
+// needs glClipControl (GL 4.5 / ARB_clip_control); older contexts fall back to
+// logarithmic depth written by the vertex shaders over [nearPlane, farPlane].
+enum DepthMode
+{
+    DEPTH_STANDARD = 0,
+    DEPTH_REVERSED,
+    DEPTH_LOGARITHMIC
+};
+
+// farPlane for DEPTH_LOGARITHMIC. Log depth keeps its relative precision at any
+// range, so the plane sits far past the scene (bodies reach ~150 units out);
+// unlike reversed-Z there still is one, and geometry beyond it is clipped.
+const float LOG_DEPTH_FAR_PLANE = 1.0e5f;
+
 // Improved default values for solar system viewing
 const float YAW = -90.0f;
 const float PITCH = 0.0f;
@@ -22,6 +37,12 @@ const float SPEED = 8.0f;        // Slightly faster for large solar system
 const float SENSITIVITY = 0.08f; // Lower sensitivity for smoother control
 const float ZOOM = 45.0f;
 
+// Proximity speed scaling: SPEED applies at SPEED_REFERENCE_DISTANCE from the
+// nearest surface and scales linearly with clearance between the two limits.
+const float SPEED_REFERENCE_DISTANCE = 10.0f;
+const float SPEED_SCALE_MIN = 0.02f;
+const float SPEED_SCALE_MAX = 50.0f;
+
 class Camera
 {
 public:
@@ -37,19 +58,26 @@ public:
     mutable float aspectRatio = 16.0f / 9.0f;
     mutable float nearPlane = 0.1f;
     mutable float farPlane = 1000.0f;
+    DepthMode depthMode = DEPTH_STANDARD;
 
     Camera(glm::vec3 position);
 
     glm::mat4 GetViewMatrix();
     glm::mat4 getViewMatrix() const { return const_cast<Camera *>(this)->GetViewMatrix(); }
 
-    // Projection (useful later for picking)
+    // Projection (useful later for picking); infinite and reversed for DEPTH_REVERSED
     glm::mat4 getProjectionMatrix() const;
+    // Camera block depthParams: x = DepthMode, y = log-depth coefficient, z = far plane NDC depth
+    glm::vec4 getDepthParams() const;
     void setAspectRatio(float ratio) { aspectRatio = ratio; }
 
+    // Pixels covered by one world unit at unit distance, for screen-size LOD
+    float getPixelScale(int viewportHeight) const;
+
     void ProcessKeyboard(Camera_Movement direction, float deltaTime);
     void ProcessMouseMovement(float xoffset, float yoffset, bool constrainPitch = true);
     void ProcessMouseScroll(float yoffset);
+    void ScaleSpeedToClearance(float surfaceDistance);
 
     void SetTrackingMode(bool enabled, glm::vec3 target = glm::vec3(0.0f));
     void UpdateTracking(float deltaTime);
@@ -2,7 +2,7 @@
 #include <iostream>
 
 CelestialBody::CelestialBody(const std::string &name, float radius, const std::string &texturePath)
-    : m_name(name), m_radius(radius), m_position(0.0f), m_rotation(0.0f), m_rotationSpeed(1.0f)
+    : m_name(name), m_radius(radius), m_position(0.0f), m_rotation(0.0f), m_rotationSpeed(1.0f), m_texturePath(texturePath)
 {
     try
     {
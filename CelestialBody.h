@@ -6,6 +6,7 @@
 #include <string>
 #include "Shader.h"
 #include "Texture.h"
+#include "SphereBatch.h"
 
 class CelestialBody
 {
@@ -16,16 +17,30 @@ public:
 
     // Pure virtual functions - must be implemented by derived classes
     virtual void update(float deltaTime) = 0;
-    virtual void render(Shader &shader, unsigned int sphereVAO, int vertexCount) = 0;
     virtual glm::mat4 getModelMatrix() const = 0;
 
+    // SphereFlags for the instanced sphere pass
+    virtual unsigned int sphereFlags() const { return 0; }
+
     // Getters
     std::string getName() const { return m_name; }
     float getRadius() const { return m_radius; }
     glm::vec3 getPosition() const { return m_position; }
+    const std::string &getTexturePath() const { return m_texturePath; }
+    const Texture *getTexture() const { return m_texture; }
+    int getTextureLayer() const { return m_textureLayer; }
+    int getLodLevel() const { return m_lodLevel; }
+    bool isSprite() const { return m_sprite; }
+
+    // The parts of getModelMatrix(): translate(position) * rotateY * uniform scale
+    float getRotationY() const { return m_rotation.y; }
+    virtual float getScale() const { return m_radius; }
 
     // Setters
     void setPosition(const glm::vec3 &position) { m_position = position; }
+    void setTextureLayer(int layer) { m_textureLayer = layer; }
+    void setLodLevel(int level) { m_lodLevel = level; }
+    void setSprite(bool sprite) { m_sprite = sprite; }
 
 protected:
     std::string m_name;
@@ -34,6 +49,10 @@ protected:
     glm::vec3 m_rotation;
     float m_rotationSpeed;
     Texture *m_texture;
+    std::string m_texturePath;
+    int m_textureLayer = 0;
+    int m_lodLevel = 2; // sphere mesh level used last frame
+    bool m_sprite = false; // drawn as a point sprite last frame
 };
 
 #endif
@@ -0,0 +1,265 @@
+#include "CollisionWorld.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+
+// Below this many items a sweep runs inline; waking workers costs more
+static const int PARALLEL_GRAIN = 1024;
+
+static int groupIndex(unsigned group)
+{
+    int idx = 0;
+    while (group > 1)
+    {
+        group >>= 1;
+        ++idx;
+    }
+    return idx;
+}
+
+CollisionWorld::CollisionWorld(unsigned threads)
+    : m_pool(threads)
+{
+    m_threadContacts.resize(m_pool.slots());
+}
+
+void CollisionWorld::clear()
+{
+    m_x.clear();
+    m_y.clear();
+    m_z.clear();
+    m_r.clear();
+    m_group.clear();
+    m_mask.clear();
+    m_lists.clear();
+    m_contacts.clear();
+    m_listsDirty = true;
+}
+
+int CollisionWorld::addProxy(const glm::vec3 &center, float radius, unsigned group, unsigned mask)
+{
+    m_x.push_back(center.x);
+    m_y.push_back(center.y);
+    m_z.push_back(center.z);
+    m_r.push_back(radius);
+    m_group.push_back(group);
+    m_mask.push_back(mask);
+    m_listsDirty = true;
+    return (int)m_x.size() - 1;
+}
+
+void CollisionWorld::setProxy(int id, const glm::vec3 &center)
+{
+    m_x[id] = center.x;
+    m_y[id] = center.y;
+    m_z[id] = center.z;
+}
+
+void CollisionWorld::setProxy(int id, const glm::vec3 &center, float radius)
+{
+    setProxy(id, center);
+    if (m_r[id] != radius)
+    {
+        m_r[id] = radius;
+        m_listsDirty = true; // per-list max radius bounds the pair search
+    }
+}
+
+int CollisionWorld::chooseAxis() const
+{
+    // Sweep along the axis with the largest spread so the fewest intervals overlap
+    const std::vector<float> *axes[3] = {&m_x, &m_y, &m_z};
+    float var[3];
+    int n = (int)m_x.size();
+    for (int a = 0; a < 3; ++a)
+    {
+        const std::vector<float> &v = *axes[a];
+        double sum = 0.0, sum2 = 0.0;
+        for (int i = 0; i < n; ++i)
+        {
+            sum += v[i];
+            sum2 += (double)v[i] * v[i];
+        }
+        double mean = sum / n;
+        var[a] = (float)(sum2 / n - mean * mean);
+    }
+
+    // Hysteresis: switching axes costs a full re-sort
+    int best = m_axis;
+    for (int a = 0; a < 3; ++a)
+        if (var[a] > var[best] * 1.2f)
+            best = a;
+    return best;
+}
+
+void CollisionWorld::rebuildLists()
+{
+    m_lists.clear();
+    for (int id = 0; id < (int)m_x.size(); ++id)
+    {
+        int g = groupIndex(m_group[id]);
+        if (g >= (int)m_lists.size())
+            m_lists.resize(g + 1);
+        SweepList &list = m_lists[g];
+        list.order.push_back(id);
+        list.mask |= m_mask[id];
+        list.maxRadius = std::max(list.maxRadius, m_r[id]);
+    }
+    m_listsDirty = false;
+}
+
+void CollisionWorld::sortList(SweepList &list)
+{
+    const std::vector<float> &c = (m_axis == 0) ? m_x : (m_axis == 1) ? m_y : m_z;
+    std::vector<int> &order = list.order;
+    int n = (int)order.size();
+
+    if (!list.sorted)
+    {
+        std::sort(order.begin(), order.end(), [&](int a, int b)
+                  { return c[a] - m_r[a] < c[b] - m_r[b]; });
+        list.sorted = true;
+    }
+    else
+    {
+        // Insertion sort: near-linear when the previous order is almost right
+        for (int k = 1; k < n; ++k)
+        {
+            int id = order[k];
+            float key = c[id] - m_r[id];
+            int j = k - 1;
+            while (j >= 0 && c[order[j]] - m_r[order[j]] > key)
+            {
+                order[j + 1] = order[j];
+                --j;
+            }
+            order[j + 1] = id;
+        }
+    }
+
+    list.min.resize(n);
+    list.max.resize(n);
+    parallelRange(n, [&](int begin, int end, int)
+                  {
+                      for (int k = begin; k < end; ++k)
+                      {
+                          int id = order[k];
+                          list.min[k] = c[id] - m_r[id];
+                          list.max[k] = c[id] + m_r[id];
+                      } });
+}
+
+void CollisionWorld::parallelRange(int count, const std::function<void(int, int, int)> &fn)
+{
+    if (count < PARALLEL_GRAIN)
+        fn(0, count, 0);
+    else
+        m_pool.parallelFor(count, fn);
+}
+
+void CollisionWorld::narrowPhase(int a, int b, std::vector<Contact> &out) const
+{
+    if (!(m_mask[a] & m_group[b]) && !(m_mask[b] & m_group[a]))
+        return;
+    if (m_r[a] <= 0.0f || m_r[b] <= 0.0f)
+        return;
+
+    float dx = m_x[b] - m_x[a];
+    float dy = m_y[b] - m_y[a];
+    float dz = m_z[b] - m_z[a];
+    float rr = m_r[a] + m_r[b];
+    float d2 = dx * dx + dy * dy + dz * dz;
+    if (d2 >= rr * rr)
+        return;
+
+    float d = std::sqrt(d2);
+    glm::vec3 nrm = (d > 1e-6f) ? glm::vec3(dx, dy, dz) / d : glm::vec3(0.0f, 1.0f, 0.0f);
+    if (a < b)
+        out.push_back(Contact{a, b, nrm, rr - d});
+    else
+        out.push_back(Contact{b, a, -nrm, rr - d});
+}
+
+void CollisionWorld::sweepSelf(const SweepList &list, int begin, int end, std::vector<Contact> &out) const
+{
+    int n = (int)list.order.size();
+    for (int k = begin; k < end; ++k)
+    {
+        float maxA = list.max[k];
+        for (int j = k + 1; j < n && list.min[j] <= maxA; ++j)
+            narrowPhase(list.order[k], list.order[j], out);
+    }
+}
+
+void CollisionWorld::sweepPair(const SweepList &small, const SweepList &large, int begin, int end, std::vector<Contact> &out) const
+{
+    // An interval in `large` can't reach back further than twice its max radius,
+    // so each query starts from a binary search instead of a full merge.
+    float reach = 2.0f * large.maxRadius;
+    int n = (int)large.order.size();
+    for (int k = begin; k < end; ++k)
+    {
+        float lo = small.min[k], hi = small.max[k];
+        int j = (int)(std::lower_bound(large.min.begin(), large.min.end(), lo - reach) - large.min.begin());
+        for (; j < n && large.min[j] <= hi; ++j)
+            if (large.max[j] >= lo)
+                narrowPhase(small.order[k], large.order[j], out);
+    }
+}
+
+void CollisionWorld::step()
+{
+    auto t0 = std::chrono::steady_clock::now();
+    m_contacts.clear();
+
+    if (m_x.size() >= 2)
+    {
+        int axis = chooseAxis();
+        if (m_listsDirty)
+            rebuildLists();
+        if (axis != m_axis)
+        {
+            m_axis = axis;
+            for (auto &list : m_lists)
+                list.sorted = false;
+        }
+        for (auto &list : m_lists)
+            sortList(list);
+
+        for (auto &v : m_threadContacts)
+            v.clear();
+
+        int groups = (int)m_lists.size();
+        for (int gi = 0; gi < groups; ++gi)
+        {
+            for (int gj = gi; gj < groups; ++gj)
+            {
+                const SweepList &a = m_lists[gi];
+                const SweepList &b = m_lists[gj];
+                if (a.order.empty() || b.order.empty())
+                    continue;
+                if (!(a.mask & (1u << gj)) && !(b.mask & (1u << gi)))
+                    continue;
+
+                if (gi == gj)
+                {
+                    parallelRange((int)a.order.size(), [&](int begin, int end, int slot)
+                                  { sweepSelf(a, begin, end, m_threadContacts[slot]); });
+                }
+                else
+                {
+                    const SweepList &small = (a.order.size() <= b.order.size()) ? a : b;
+                    const SweepList &large = (&small == &a) ? b : a;
+                    parallelRange((int)small.order.size(), [&](int begin, int end, int slot)
+                                  { sweepPair(small, large, begin, end, m_threadContacts[slot]); });
+                }
+            }
+        }
+
+        for (auto &v : m_threadContacts)
+            m_contacts.insert(m_contacts.end(), v.begin(), v.end());
+    }
+
+    auto t1 = std::chrono::steady_clock::now();
+    m_lastStepMs = std::chrono::duration<float, std::milli>(t1 - t0).count();
+}
@@ -0,0 +1,80 @@
+#ifndef COLLISIONWORLD_H
+#define COLLISIONWORLD_H
+
+#include <vector>
+#include <glm/glm.hpp>
+#include "ThreadPool.h"
+
+// Collision groups; a pair is tested when either side's mask includes the other's group
+enum CollisionGroup
+{
+    COLLIDE_ASTEROID = 1 << 0,
+    COLLIDE_BODY = 1 << 1,
+    COLLIDE_SATELLITE = 1 << 2
+};
+
+struct Contact
+{
+    int a, b;         // proxy ids, a < b
+    glm::vec3 normal; // from a towards b
+    float depth;      // penetration distance
+};
+
+// Sort-and-sweep broad phase over bounding spheres with an exact sphere
+// narrow phase. Each collision group keeps its own list sorted along the
+// sweep axis; groups that never touch themselves (the asteroid belt) are only
+// swept against the other lists, so their internal overlaps cost nothing.
+// Sorted orders persist between steps so coherent motion only costs an
+// insertion-sort pass, and the sweeps are split across threads.
+class CollisionWorld
+{
+public:
+    explicit CollisionWorld(unsigned threads = 0);
+
+    void clear();
+    int addProxy(const glm::vec3 &center, float radius, unsigned group, unsigned mask);
+    void setProxy(int id, const glm::vec3 &center);
+    // A radius of 0 disables the proxy: it never reports contacts
+    void setProxy(int id, const glm::vec3 &center, float radius);
+
+    // Broad + narrow phase over the current proxies
+    void step();
+
+    const std::vector<Contact> &contacts() const { return m_contacts; }
+    int proxyCount() const { return (int)m_x.size(); }
+    float lastStepMs() const { return m_lastStepMs; }
+
+private:
+    struct SweepList
+    {
+        unsigned mask = 0; // union of member masks
+        float maxRadius = 0.0f;
+        bool sorted = false;
+        std::vector<int> order;
+        std::vector<float> min, max; // in sorted order along m_axis
+    };
+
+    ThreadPool m_pool;
+
+    // Proxies, structure-of-arrays
+    std::vector<float> m_x, m_y, m_z, m_r;
+    std::vector<unsigned> m_group, m_mask;
+
+    int m_axis = 0;
+    bool m_listsDirty = true;
+    std::vector<SweepList> m_lists; // one per group bit
+
+    std::vector<std::vector<Contact>> m_threadContacts;
+    std::vector<Contact> m_contacts;
+    float m_lastStepMs = 0.0f;
+
+    int chooseAxis() const;
+    void rebuildLists();
+    void sortList(SweepList &list);
+    void parallelRange(int count, const std::function<void(int, int, int)> &fn);
+    void narrowPhase(int a, int b, std::vector<Contact> &out) const;
+    void sweepSelf(const SweepList &list, int begin, int end, std::vector<Contact> &out) const;
+    void sweepPair(const SweepList &small, const SweepList &large, int begin, int end, std::vector<Contact> &out) const;
+};
+
+#endif
@@ -0,0 +1,63 @@
+#include "DynamicResolution.h"
+#include <algorithm>
+#include <cmath>
+
+const float DynamicResolution::MIN_SCALE = 0.5f;
+const float DynamicResolution::STEP = 0.05f;
+
+// Aim a little under the budget, and only grow when well under it
+static const float TARGET_FRACTION = 0.9f;
+static const float GROW_FRACTION = 0.75f;
+static const float SMOOTHING = 0.2f;
+
+DynamicResolution::DynamicResolution(float budgetMs)
+    : m_budgetMs(budgetMs)
+{
+}
+
+void DynamicResolution::setEnabled(bool enabled)
+{
+    m_enabled = enabled;
+    m_scale = 1.0f;
+    m_averageMs = -1.0f;
+    m_settle = SETTLE_FRAMES;
+}
+
+void DynamicResolution::update(float gpuMs)
+{
+    if (!m_enabled || gpuMs < 0.0f)
+        return;
+    if (m_settle > 0)
+    {
+        --m_settle;
+        return;
+    }
+
+    m_averageMs = (m_averageMs < 0.0f) ? gpuMs : m_averageMs + (gpuMs - m_averageMs) * SMOOTHING;
+
+    // GPU time roughly follows the pixel count, the square of the scale
+    float next = m_scale;
+    if (m_averageMs > m_budgetMs)
+    {
+        float wanted = m_scale * std::sqrt(m_budgetMs * TARGET_FRACTION / m_averageMs);
+        next = std::floor(wanted / STEP) * STEP;
+    }
+    else if (m_averageMs < m_budgetMs * GROW_FRACTION)
+    {
+        next = m_scale + STEP;
+    }
+    next = std::clamp(next, MIN_SCALE, 1.0f);
+
+    if (std::fabs(next - m_scale) > STEP * 0.5f)
+    {
+        m_scale = next;
+        m_averageMs = -1.0f;
+        m_settle = SETTLE_FRAMES;
+    }
+}
+
+void DynamicResolution::targetSize(int width, int height, int &sceneWidth, int &sceneHeight) const
+{
+    sceneWidth = std::max((int)std::lround(width * m_scale), 1);
+    sceneHeight = std::max((int)std::lround(height * m_scale), 1);
+}
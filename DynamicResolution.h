@@ -0,0 +1,42 @@
+#ifndef DYNAMICRESOLUTION_H
+#define DYNAMICRESOLUTION_H
+
+// Picks the scene's render scale from measured GPU frame time. The scene is
+// drawn offscreen at scale * framebuffer size and stretched to the window, so
+// weak GPUs driving large panels hold the frame budget at the cost of
+// sharpness. The scale moves in fixed steps (few distinct target sizes for
+// the render graph to pool), drops at once when over budget and climbs back
+// one step at a time; after each change it waits out the timer query latency
+// before judging the new size.
+class DynamicResolution
+{
+public:
+    static const float MIN_SCALE;
+    static const float STEP;
+
+    explicit DynamicResolution(float budgetMs = 1000.0f / 60.0f);
+
+    void setEnabled(bool enabled);
+    bool enabled() const { return m_enabled; }
+    void setBudget(float ms) { m_budgetMs = ms; }
+    float budget() const { return m_budgetMs; }
+
+    // GPU time of the last measured frame in ms (negative when not known yet)
+    void update(float gpuMs);
+
+    float scale() const { return m_scale; }
+    // Scene target size for a framebuffer of `width` x `height` (at least 1 x 1)
+    void targetSize(int width, int height, int &sceneWidth, int &sceneHeight) const;
+
+private:
+    // RenderGraph reads its timer queries a few frames late
+    static const int SETTLE_FRAMES = 4;
+
+    float m_budgetMs;
+    float m_scale = 1.0f;
+    bool m_enabled = true;
+    float m_averageMs = -1.0f; // smoothed over the frames since the last change
+    int m_settle = 0;
+};
+
+#endif
@@ -0,0 +1,99 @@
+#include "FramePacer.h"
+#include <GLFW/glfw3.h>
+#include <algorithm>
+#include <cmath>
+#include <thread>
+
+// Sleeping can overshoot by about a scheduler tick; spin the rest
+static const std::chrono::microseconds SPIN_MARGIN(2000);
+
+void FramePacer::setTargetFps(double fps)
+{
+    m_targetFps = std::max(fps, 0.0);
+    m_scheduled = false;
+}
+
+float FramePacer::frameBudgetMs() const
+{
+    return (float)(1000.0 / (m_targetFps > 0.0 ? m_targetFps : 60.0));
+}
+
+void FramePacer::setSwapInterval(int interval)
+{
+    m_swapInterval = interval;
+    glfwSwapInterval(interval);
+}
+
+void FramePacer::beginFrame()
+{
+    if (m_lowLatency)
+        waitForSlot();
+}
+
+void FramePacer::endFrame()
+{
+    Clock::time_point now = Clock::now();
+    if (m_swapped)
+        record(std::chrono::duration<float, std::milli>(now - m_lastSwap).count());
+    m_lastSwap = now;
+    m_swapped = true;
+
+    if (!m_lowLatency)
+        waitForSlot();
+}
+
+void FramePacer::resetClock()
+{
+    m_scheduled = false;
+    m_swapped = false;
+}
+
+void FramePacer::waitForSlot()
+{
+    if (m_targetFps <= 0.0)
+        return;
+
+    Clock::duration period = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(1.0 / m_targetFps));
+    Clock::time_point now = Clock::now();
+
+    // Slots follow each other; after a long frame start over rather than
+    // rushing several short ones to catch up
+    if (!m_scheduled || now > m_deadline + period)
+    {
+        m_deadline = now + period;
+        m_scheduled = true;
+        return;
+    }
+
+    if (m_deadline - now > SPIN_MARGIN)
+        std::this_thread::sleep_for(m_deadline - now - SPIN_MARGIN);
+    while (Clock::now() < m_deadline)
+        std::this_thread::yield();
+    m_deadline += period;
+}
+
+void FramePacer::record(float ms)
+{
+    if ((int)m_intervals.size() < WINDOW)
+        m_intervals.push_back(ms);
+    else
+        m_intervals[m_next] = ms;
+    m_next = (m_next + 1) % WINDOW;
+
+    double sum = 0.0, sumSquares = 0.0;
+    float lo = m_intervals[0], hi = m_intervals[0];
+    for (float interval : m_intervals)
+    {
+        sum += interval;
+        sumSquares += (double)interval * interval;
+        lo = std::min(lo, interval);
+        hi = std::max(hi, interval);
+    }
+    int n = (int)m_intervals.size();
+    double mean = sum / n;
+    m_stats.meanMs = (float)mean;
+    m_stats.jitterMs = (float)std::sqrt(std::max(sumSquares / n - mean * mean, 0.0));
+    m_stats.minMs = lo;
+    m_stats.maxMs = hi;
+    m_stats.samples = n;
+}
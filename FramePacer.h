@@ -0,0 +1,67 @@
+#ifndef FRAMEPACER_H
+#define FRAMEPACER_H
+
+#include <chrono>
+#include <vector>
+
+// Frame limiter and frame-time statistics for the main loop.
+//
+// The loop calls beginFrame() at the top and endFrame() right after
+// glfwSwapBuffers. With a target FPS the pacer holds each frame to its slot:
+// normally by sleeping after the swap; in low-latency mode by sleeping in
+// beginFrame() instead, so the events and input read just after it are as
+// fresh as possible when the frame is rendered. Sleeps are coarse until the
+// last couple of milliseconds, which spin, so slots stay even.
+class FramePacer
+{
+public:
+    struct Stats
+    {
+        float meanMs = 0.0f;   // swap-to-swap interval
+        float jitterMs = 0.0f; // standard deviation of the interval
+        float minMs = 0.0f, maxMs = 0.0f;
+        int samples = 0;
+    };
+
+    // Recent swaps the statistics cover
+    static const int WINDOW = 120;
+
+    // 0 = no limit
+    void setTargetFps(double fps);
+    double targetFps() const { return m_targetFps; }
+    // Milliseconds per frame at the target, or at 60 FPS without one
+    float frameBudgetMs() const;
+
+    // glfwSwapInterval for the current context (0 = off, 1 = vsync, -1 = adaptive where supported)
+    void setSwapInterval(int interval);
+    int swapInterval() const { return m_swapInterval; }
+
+    void setLowLatency(bool enabled) { m_lowLatency = enabled; }
+    bool lowLatency() const { return m_lowLatency; }
+
+    void beginFrame();
+    void endFrame();
+    // Forget the schedule and the last swap, e.g. after the loop slept on purpose
+    void resetClock();
+
+    const Stats &stats() const { return m_stats; }
+
+private:
+    typedef std::chrono::steady_clock Clock;
+
+    double m_targetFps = 0.0;
+    int m_swapInterval = 1;
+    bool m_lowLatency = false;
+    bool m_scheduled = false; // m_deadline is valid
+    Clock::time_point m_deadline;
+    bool m_swapped = false;   // m_lastSwap is valid
+    Clock::time_point m_lastSwap;
+    std::vector<float> m_intervals; // ring of the last WINDOW intervals
+    int m_next = 0;
+    Stats m_stats;
+
+    void waitForSlot();
+    void record(float ms);
+};
+
+#endif
@@ -0,0 +1,88 @@
+#include "FrameUniforms.h"
+
+static_assert(sizeof(CameraBlock) == 160, "CameraBlock must match the std140 Camera block");
+static_assert(sizeof(LightingBlock) == 96, "LightingBlock must match the std140 Lighting block");
+
+// The only GLSL copy of the blocks above; keep the two in step
+static const char *const PRELUDE = R"GLSL(
+layout (std140) uniform Camera
+{
+    mat4 projection;
+    mat4 view;
+    vec3 viewPos;                 // Camera position
+    vec4 depthParams;             // x = DepthMode, y = log-depth coefficient, z = far plane depth
+};
+
+layout (std140) uniform Lighting
+{
+    mat4 lightSpaceMatrix;
+    vec3 lightPos;                // Sun position
+    float atmosphereIntensity;    // Glow strength
+    vec3 atmosphereColor;         // Glow color
+};
+
+// Logarithmic depth (DEPTH_LOGARITHMIC) spreads precision evenly over the range;
+// standard and reversed-Z depth come straight from the projection
+vec4 SceneDepth(vec4 clipPos)
+{
+    if (depthParams.x == 2.0)
+        clipPos.z = (log2(max(1e-6, 1.0 + clipPos.w)) * depthParams.y - 1.0) * clipPos.w;
+    return clipPos;
+}
+)GLSL";
+
+const char *FrameUniforms::prelude()
+{
+    return PRELUDE;
+}
+
+FrameUniforms::FrameUniforms()
+{
+    glGenBuffers(1, &m_cameraUBO);
+    glBindBuffer(GL_UNIFORM_BUFFER, m_cameraUBO);
+    glBufferData(GL_UNIFORM_BUFFER, sizeof(CameraBlock), nullptr, GL_DYNAMIC_DRAW);
+    glBindBufferBase(GL_UNIFORM_BUFFER, CAMERA_BLOCK_BINDING, m_cameraUBO);
+
+    glGenBuffers(1, &m_lightingUBO);
+    glBindBuffer(GL_UNIFORM_BUFFER, m_lightingUBO);
+    glBufferData(GL_UNIFORM_BUFFER, sizeof(LightingBlock), nullptr, GL_DYNAMIC_DRAW);
+    glBindBufferBase(GL_UNIFORM_BUFFER, LIGHTING_BLOCK_BINDING, m_lightingUBO);
+
+    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+}
+
+FrameUniforms::~FrameUniforms()
+{
+    if (m_cameraUBO)
+        glDeleteBuffers(1, &m_cameraUBO);
+    if (m_lightingUBO)
+        glDeleteBuffers(1, &m_lightingUBO);
+}
+
+void FrameUniforms::attach(const Shader &shader) const
+{
+    // GLSL 3.30 has no binding layout qualifier, so bindings are set here
+    GLuint camera = glGetUniformBlockIndex(shader.ID, "Camera");
+    if (camera != GL_INVALID_INDEX)
+        glUniformBlockBinding(shader.ID, camera, CAMERA_BLOCK_BINDING);
+
+    GLuint lighting = glGetUniformBlockIndex(shader.ID, "Lighting");
+    if (lighting != GL_INVALID_INDEX)
+        glUniformBlockBinding(shader.ID, lighting, LIGHTING_BLOCK_BINDING);
+}
+
+void FrameUniforms::setCamera(const glm::mat4 &projection, const glm::mat4 &view, const glm::vec3 &viewPos,
+                              const glm::vec4 &depthParams)
+{
+    CameraBlock block{projection, view, viewPos, 0.0f, depthParams};
+    glBindBuffer(GL_UNIFORM_BUFFER, m_cameraUBO);
+    glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(block), &block);
+}
+
+void FrameUniforms::setLighting(const glm::mat4 &lightSpaceMatrix, const glm::vec3 &lightPos,
+                                const glm::vec3 &atmosphereColor, float atmosphereIntensity)
+{
+    LightingBlock block{lightSpaceMatrix, lightPos, atmosphereIntensity, atmosphereColor, 0.0f};
+    glBindBuffer(GL_UNIFORM_BUFFER, m_lightingUBO);
+    glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(block), &block);
+}
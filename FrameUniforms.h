@@ -0,0 +1,58 @@
+#ifndef FRAMEUNIFORMS_H
+#define FRAMEUNIFORMS_H
+
+#include <glm/glm.hpp>
+#include <GL/glew.h>
+#include "Shader.h"
+
+// Binding points of the shared uniform blocks
+enum UniformBlockBinding
+{
+    CAMERA_BLOCK_BINDING = 0,
+    LIGHTING_BLOCK_BINDING = 1
+};
+
+// std140 mirrors of the GLSL blocks; a vec3 followed by a float shares one 16-byte slot
+struct CameraBlock
+{
+    glm::mat4 projection;
+    glm::mat4 view;
+    glm::vec3 viewPos;
+    float pad0;
+    glm::vec4 depthParams; // see Camera::getDepthParams
+};
+
+struct LightingBlock
+{
+    glm::mat4 lightSpaceMatrix;
+    glm::vec3 lightPos;
+    float atmosphereIntensity;
+    glm::vec3 atmosphereColor;
+    float pad0;
+};
+
+// Camera and lighting data written once per frame into two uniform buffers
+// and read by every program through the Camera / Lighting blocks.
+class FrameUniforms
+{
+public:
+    FrameUniforms();
+    ~FrameUniforms();
+
+    // GLSL declarations of the Camera and Lighting blocks plus SceneDepth(), for
+    // the `defines` argument of every program that reads them (see Shader)
+    static const char *prelude();
+
+    // Point the program's Camera / Lighting blocks (whichever it uses) at the shared buffers
+    void attach(const Shader &shader) const;
+
+    void setCamera(const glm::mat4 &projection, const glm::mat4 &view, const glm::vec3 &viewPos,
+                   const glm::vec4 &depthParams);
+    void setLighting(const glm::mat4 &lightSpaceMatrix, const glm::vec3 &lightPos,
+                     const glm::vec3 &atmosphereColor, float atmosphereIntensity);
+
+private:
+    GLuint m_cameraUBO = 0, m_lightingUBO = 0;
+};
+
+#endif
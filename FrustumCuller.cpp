@@ -0,0 +1,121 @@
+#include "FrustumCuller.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define FRUSTUM_SSE2 1
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define FRUSTUM_NEON 1
+#endif
+
+static const float PAD_RADIUS = -1e30f;
+
+Frustum Frustum::fromMatrix(const glm::mat4 &m)
+{
+    // glm is column-major: row i is (m[0][i], m[1][i], m[2][i], m[3][i])
+    glm::vec4 row0(m[0][0], m[1][0], m[2][0], m[3][0]);
+    glm::vec4 row1(m[0][1], m[1][1], m[2][1], m[3][1]);
+    glm::vec4 row2(m[0][2], m[1][2], m[2][2], m[3][2]);
+    glm::vec4 row3(m[0][3], m[1][3], m[2][3], m[3][3]);
+
+    Frustum f;
+    f.planes[0] = row3 + row0; // left
+    f.planes[1] = row3 - row0; // right
+    f.planes[2] = row3 + row1; // bottom
+    f.planes[3] = row3 - row1; // top
+    f.planes[4] = row3 + row2; // near
+    f.planes[5] = row3 - row2; // far
+    for (glm::vec4 &p : f.planes)
+        p /= glm::length(glm::vec3(p));
+    return f;
+}
+
+bool Frustum::intersectsSphere(const glm::vec3 &center, float radius) const
+{
+    for (const glm::vec4 &p : planes)
+        if (glm::dot(glm::vec3(p), center) + p.w < -radius)
+            return false;
+    return true;
+}
+
+void FrustumCuller::clear()
+{
+    m_count = 0;
+    m_x.clear();
+    m_y.clear();
+    m_z.clear();
+    m_r.clear();
+}
+
+int FrustumCuller::add(const glm::vec3 &center, float radius)
+{
+    // Overwrite the padding slot if there is one, otherwise open a new group of 4
+    if (m_count == (int)m_x.size())
+    {
+        m_x.resize(m_count + 4, 0.0f);
+        m_y.resize(m_count + 4, 0.0f);
+        m_z.resize(m_count + 4, 0.0f);
+        m_r.resize(m_count + 4, PAD_RADIUS);
+    }
+    m_x[m_count] = center.x;
+    m_y[m_count] = center.y;
+    m_z[m_count] = center.z;
+    m_r[m_count] = radius;
+    return m_count++;
+}
+
+int FrustumCuller::cull(const Frustum &frustum, std::vector<unsigned char> &visible) const
+{
+    visible.resize(m_x.size());
+    int n = (int)m_x.size();
+
+#if defined(FRUSTUM_SSE2)
+    for (int i = 0; i < n; i += 4)
+    {
+        __m128 x = _mm_loadu_ps(&m_x[i]);
+        __m128 y = _mm_loadu_ps(&m_y[i]);
+        __m128 z = _mm_loadu_ps(&m_z[i]);
+        __m128 negR = _mm_sub_ps(_mm_setzero_ps(), _mm_loadu_ps(&m_r[i]));
+        __m128 inside = _mm_castsi128_ps(_mm_set1_epi32(-1));
+        for (const glm::vec4 &p : frustum.planes)
+        {
+            __m128 d = _mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_set1_ps(p.x), x), _mm_mul_ps(_mm_set1_ps(p.y), y)),
+                                  _mm_add_ps(_mm_mul_ps(_mm_set1_ps(p.z), z), _mm_set1_ps(p.w)));
+            inside = _mm_and_ps(inside, _mm_cmpge_ps(d, negR));
+        }
+        int mask = _mm_movemask_ps(inside);
+        for (int k = 0; k < 4; ++k)
+            visible[i + k] = (unsigned char)((mask >> k) & 1);
+    }
+#elif defined(FRUSTUM_NEON)
+    for (int i = 0; i < n; i += 4)
+    {
+        float32x4_t x = vld1q_f32(&m_x[i]);
+        float32x4_t y = vld1q_f32(&m_y[i]);
+        float32x4_t z = vld1q_f32(&m_z[i]);
+        float32x4_t negR = vnegq_f32(vld1q_f32(&m_r[i]));
+        uint32x4_t inside = vdupq_n_u32(0xffffffffu);
+        for (const glm::vec4 &p : frustum.planes)
+        {
+            float32x4_t d = vdupq_n_f32(p.w);
+            d = vmlaq_n_f32(d, x, p.x);
+            d = vmlaq_n_f32(d, y, p.y);
+            d = vmlaq_n_f32(d, z, p.z);
+            inside = vandq_u32(inside, vcgeq_f32(d, negR));
+        }
+        visible[i + 0] = (unsigned char)(vgetq_lane_u32(inside, 0) & 1);
+        visible[i + 1] = (unsigned char)(vgetq_lane_u32(inside, 1) & 1);
+        visible[i + 2] = (unsigned char)(vgetq_lane_u32(inside, 2) & 1);
+        visible[i + 3] = (unsigned char)(vgetq_lane_u32(inside, 3) & 1);
+    }
+#else
+    for (int i = 0; i < n; ++i)
+        visible[i] = frustum.intersectsSphere(glm::vec3(m_x[i], m_y[i], m_z[i]), m_r[i]) ? 1 : 0;
+#endif
+
+    visible.resize(m_count);
+    int count = 0;
+    for (unsigned char v : visible)
+        count += v;
+    return count;
+}
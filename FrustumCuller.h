@@ -0,0 +1,35 @@
+#ifndef FRUSTUMCULLER_H
+#define FRUSTUMCULLER_H
+
+#include <vector>
+#include <glm/glm.hpp>
+
+// Six normalized planes (xyz = inward normal, w = distance), extracted from a
+// view-projection matrix (Gribb & Hartmann). Works for perspective and ortho.
+struct Frustum
+{
+    glm::vec4 planes[6];
+
+    static Frustum fromMatrix(const glm::mat4 &viewProjection);
+    bool intersectsSphere(const glm::vec3 &center, float radius) const;
+};
+
+// Bounding spheres kept as structure-of-arrays so four of them are tested
+// against a plane per SIMD instruction (SSE2 or NEON, scalar elsewhere).
+class FrustumCuller
+{
+public:
+    void clear();
+    int add(const glm::vec3 &center, float radius);
+    int size() const { return m_count; }
+
+    // visible[i] = 1 when sphere i touches the frustum. Returns the visible count.
+    int cull(const Frustum &frustum, std::vector<unsigned char> &visible) const;
+
+private:
+    int m_count = 0;
+    // Padded to a multiple of 4; padding spheres can never be visible
+    std::vector<float> m_x, m_y, m_z, m_r;
+};
+
+#endif
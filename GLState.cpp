@@ -0,0 +1,191 @@
+#include "GLState.h"
+
+static const GLuint UNKNOWN = 0xffffffffu;
+
+// Capabilities worth tracking; anything else goes straight to GL
+static const GLenum TRACKED_CAPS[] = {GL_BLEND, GL_DEPTH_TEST, GL_CULL_FACE, GL_PROGRAM_POINT_SIZE};
+static const int TRACKED_CAP_COUNT = sizeof(TRACKED_CAPS) / sizeof(TRACKED_CAPS[0]);
+
+struct TrackedState
+{
+    GLuint program, vao, framebuffer;
+    GLuint activeUnit;
+    GLuint texture2D[GLState::MAX_TEXTURE_UNITS];
+    GLuint texture2DArray[GLState::MAX_TEXTURE_UNITS];
+    GLuint caps[TRACKED_CAP_COUNT]; // 0 off, 1 on, UNKNOWN
+    GLenum blendSrc, blendDst, depth;
+    GLint viewport[4];
+
+    int issued, skipped;           // this frame
+    int lastIssued, lastSkipped;   // last closed frame
+};
+
+static TrackedState gState;
+static bool gValid = false;
+
+static void ensureValid()
+{
+    if (!gValid)
+        GLState::invalidate();
+}
+
+// true when the call must reach GL; updates the shadow value
+static bool changed(GLuint &slot, GLuint value)
+{
+    if (slot == value)
+    {
+        ++gState.skipped;
+        return false;
+    }
+    slot = value;
+    ++gState.issued;
+    return true;
+}
+
+static GLuint *textureSlot(GLenum target)
+{
+    if (gState.activeUnit >= (GLuint)GLState::MAX_TEXTURE_UNITS)
+        return nullptr;
+    if (target == GL_TEXTURE_2D)
+        return &gState.texture2D[gState.activeUnit];
+    if (target == GL_TEXTURE_2D_ARRAY)
+        return &gState.texture2DArray[gState.activeUnit];
+    return nullptr;
+}
+
+static GLuint *capSlot(GLenum cap)
+{
+    for (int i = 0; i < TRACKED_CAP_COUNT; ++i)
+        if (TRACKED_CAPS[i] == cap)
+            return &gState.caps[i];
+    return nullptr;
+}
+
+void GLState::invalidate()
+{
+    gValid = true;
+    gState.program = gState.vao = gState.framebuffer = UNKNOWN;
+    gState.activeUnit = UNKNOWN;
+    for (int i = 0; i < MAX_TEXTURE_UNITS; ++i)
+        gState.texture2D[i] = gState.texture2DArray[i] = UNKNOWN;
+    for (GLuint &cap : gState.caps)
+        cap = UNKNOWN;
+    gState.blendSrc = gState.blendDst = gState.depth = UNKNOWN;
+    gState.viewport[0] = gState.viewport[1] = gState.viewport[2] = gState.viewport[3] = -1;
+}
+
+void GLState::useProgram(GLuint program)
+{
+    ensureValid();
+    if (changed(gState.program, program))
+        glUseProgram(program);
+}
+
+void GLState::bindVertexArray(GLuint vao)
+{
+    ensureValid();
+    if (changed(gState.vao, vao))
+        glBindVertexArray(vao);
+}
+
+void GLState::bindFramebuffer(GLuint fbo)
+{
+    ensureValid();
+    if (changed(gState.framebuffer, fbo))
+        glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+}
+
+void GLState::activeTexture(GLenum unit)
+{
+    ensureValid();
+    if (changed(gState.activeUnit, unit - GL_TEXTURE0))
+        glActiveTexture(unit);
+}
+
+void GLState::bindTexture(GLenum target, GLuint texture)
+{
+    ensureValid();
+    GLuint *slot = textureSlot(target);
+    if (!slot)
+        ++gState.issued;
+    else if (!changed(*slot, texture))
+        return;
+    glBindTexture(target, texture);
+}
+
+void GLState::enable(GLenum cap)
+{
+    ensureValid();
+    GLuint *slot = capSlot(cap);
+    if (!slot)
+        ++gState.issued;
+    else if (!changed(*slot, 1))
+        return;
+    glEnable(cap);
+}
+
+void GLState::disable(GLenum cap)
+{
+    ensureValid();
+    GLuint *slot = capSlot(cap);
+    if (!slot)
+        ++gState.issued;
+    else if (!changed(*slot, 0))
+        return;
+    glDisable(cap);
+}
+
+void GLState::blendFunc(GLenum src, GLenum dst)
+{
+    ensureValid();
+    if (gState.blendSrc == src && gState.blendDst == dst)
+    {
+        ++gState.skipped;
+        return;
+    }
+    gState.blendSrc = src;
+    gState.blendDst = dst;
+    ++gState.issued;
+    glBlendFunc(src, dst);
+}
+
+void GLState::depthFunc(GLenum func)
+{
+    ensureValid();
+    if (changed(gState.depth, func))
+        glDepthFunc(func);
+}
+
+void GLState::viewport(GLint x, GLint y, GLsizei width, GLsizei height)
+{
+    ensureValid();
+    GLint *v = gState.viewport;
+    if (v[0] == x && v[1] == y && v[2] == width && v[3] == height)
+    {
+        ++gState.skipped;
+        return;
+    }
+    v[0] = x;
+    v[1] = y;
+    v[2] = width;
+    v[3] = height;
+    ++gState.issued;
+    glViewport(x, y, width, height);
+}
+
+void GLState::endFrame()
+{
+    gState.lastIssued = gState.issued;
+    gState.lastSkipped = gState.skipped;
+    gState.issued = gState.skipped = 0;
+}
+
+int GLState::issuedCalls()
+{
+    return gState.lastIssued;
+}
+
+int GLState::skippedCalls()
+{
+    return gState.lastSkipped;
+}
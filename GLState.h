@@ -0,0 +1,36 @@
+#ifndef GLSTATE_H
+#define GLSTATE_H
+
+#include <GL/glew.h>
+
+// Shadow copy of the GL state the frame loop touches. A call that would not
+// change anything is dropped and counted. Code that changes these bindings
+// directly (loaders, one-off setup) must be followed by invalidate().
+class GLState
+{
+public:
+    static const int MAX_TEXTURE_UNITS = 16;
+
+    static void useProgram(GLuint program);
+    static void bindVertexArray(GLuint vao);
+    static void bindFramebuffer(GLuint fbo); // GL_FRAMEBUFFER (read and draw)
+
+    static void activeTexture(GLenum unit); // GL_TEXTURE0 + n
+    static void bindTexture(GLenum target, GLuint texture); // on the active unit
+
+    static void enable(GLenum cap);
+    static void disable(GLenum cap);
+    static void blendFunc(GLenum src, GLenum dst);
+    static void depthFunc(GLenum func);
+    static void viewport(GLint x, GLint y, GLsizei width, GLsizei height);
+
+    // Forget everything; the next call of each kind goes to GL
+    static void invalidate();
+
+    // Close the frame's counters; the getters report the last closed frame
+    static void endFrame();
+    static int issuedCalls();
+    static int skippedCalls();
+};
+
+#endif
@@ -0,0 +1,186 @@
+#include "IndirectRenderer.h"
+#include "GLState.h"
+#include <algorithm>
+
+static const GLuint CULL_GROUP_SIZE = 64; // local_size_x in indirect_cull.glsl
+
+bool IndirectRenderer::supported()
+{
+    return GLEW_VERSION_4_3 && GLEW_ARB_shader_draw_parameters;
+}
+
+IndirectRenderer::IndirectRenderer()
+    : m_cullShader("indirect_cull.glsl"), m_stream(1024 * (sizeof(SphereInstance) + sizeof(Candidate)))
+{
+    glGetIntegerv(GL_SHADER_STORAGE_BUFFER_OFFSET_ALIGNMENT, &m_storageAlignment);
+    glGenVertexArrays(1, &m_vao);
+    glGenBuffers(1, &m_vbo);
+    glGenBuffers(1, &m_ebo);
+    glGenBuffers(1, &m_commandBuffer);
+    glGenBuffers(1, &m_visibleBuffer);
+}
+
+IndirectRenderer::~IndirectRenderer()
+{
+    if (m_visibleBuffer)
+        glDeleteBuffers(1, &m_visibleBuffer);
+    if (m_commandBuffer)
+        glDeleteBuffers(1, &m_commandBuffer);
+    if (m_ebo)
+        glDeleteBuffers(1, &m_ebo);
+    if (m_vbo)
+        glDeleteBuffers(1, &m_vbo);
+    if (m_vao)
+        glDeleteVertexArrays(1, &m_vao);
+}
+
+int IndirectRenderer::addMesh(const float *vertices, size_t vertexCount, const unsigned int *indices, size_t indexCount)
+{
+    MeshRange range;
+    range.firstIndex = (GLuint)m_indices.size();
+    range.indexCount = (GLuint)indexCount;
+    range.baseVertex = (GLint)(m_vertices.size() / 8);
+    m_vertices.insert(m_vertices.end(), vertices, vertices + vertexCount * 8);
+    m_indices.insert(m_indices.end(), indices, indices + indexCount);
+    m_meshes.push_back(range);
+    return (int)m_meshes.size() - 1;
+}
+
+void IndirectRenderer::finalize()
+{
+    // The cull program compiled while the meshes were added
+    m_cullShader.finalize();
+
+    GLState::bindVertexArray(m_vao);
+    glBindBuffer(GL_ARRAY_BUFFER, m_vbo);
+    glBufferData(GL_ARRAY_BUFFER, m_vertices.size() * sizeof(float), m_vertices.data(), GL_STATIC_DRAW);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_ebo);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, m_indices.size() * sizeof(unsigned int), m_indices.data(), GL_STATIC_DRAW);
+
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void *)0);
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void *)(3 * sizeof(float)));
+    glEnableVertexAttribArray(1);
+    glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void *)(6 * sizeof(float)));
+    glEnableVertexAttribArray(2);
+    GLState::bindVertexArray(0);
+
+    // The GPU copy is all we need from here on
+    m_vertices = std::vector<float>();
+    m_indices = std::vector<unsigned int>();
+}
+
+void IndirectRenderer::clear()
+{
+    m_records.clear();
+    m_candidates.clear();
+}
+
+void IndirectRenderer::add(int mesh, const SphereInstance &instance, const glm::vec4 &bounds, unsigned int passMask)
+{
+    m_records.push_back(instance);
+    m_candidates.push_back(Candidate{bounds, (GLuint)mesh, passMask, 0, 0});
+}
+
+void IndirectRenderer::upload()
+{
+    // Every command gets room for all of its candidates; the cull shader fills
+    // in how many of them survived
+    size_t meshCount = m_meshes.size();
+    std::vector<GLuint> slots(SPHERE_PASS_COUNT * meshCount, 0);
+    for (const Candidate &c : m_candidates)
+        for (int pass = 0; pass < SPHERE_PASS_COUNT; ++pass)
+            if (c.passMask & (1u << pass))
+                ++slots[pass * meshCount + c.mesh];
+
+    m_commands.resize(slots.size());
+    GLuint base = 0;
+    for (size_t i = 0; i < slots.size(); ++i)
+    {
+        const MeshRange &range = m_meshes[i % meshCount];
+        m_commands[i] = Command{range.indexCount, 0, range.firstIndex, range.baseVertex, base};
+        base += slots[i];
+    }
+
+    glBindBuffer(GL_DRAW_INDIRECT_BUFFER, m_commandBuffer);
+    glBufferData(GL_DRAW_INDIRECT_BUFFER, m_commands.size() * sizeof(Command), m_commands.data(), GL_STREAM_DRAW);
+    glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+
+    if (m_records.empty())
+        return;
+
+    // Both arrays go into this frame's stream region, bound by range below
+    m_stream.reserve(m_records.size() * sizeof(SphereInstance) + m_candidates.size() * sizeof(Candidate) +
+                     2 * (size_t)m_storageAlignment);
+    m_recordOffset = m_stream.write(m_records.data(), m_records.size() * sizeof(SphereInstance), m_storageAlignment);
+    m_candidateOffset = m_stream.write(m_candidates.data(), m_candidates.size() * sizeof(Candidate), m_storageAlignment);
+
+    // Only the GPU writes the visible list
+    if (base > m_visibleCapacity)
+    {
+        m_visibleCapacity = std::max((size_t)base, m_visibleCapacity * 2);
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_visibleBuffer);
+        glBufferData(GL_SHADER_STORAGE_BUFFER, m_visibleCapacity * sizeof(GLuint), nullptr, GL_DYNAMIC_COPY);
+    }
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+}
+
+void IndirectRenderer::cull(int pass, const Frustum &frustum, const SphereOccluders *occluders)
+{
+    if (m_records.empty())
+        return;
+
+    glm::vec4 occluderSpheres[MAX_OCCLUDERS];
+    float occluderAngles[MAX_OCCLUDERS];
+    int occluderCount = occluders ? std::min(occluders->size(), MAX_OCCLUDERS) : 0;
+    for (int i = 0; i < occluderCount; ++i)
+    {
+        const SphereOccluders::Occluder &o = occluders->occluder(i);
+        occluderSpheres[i] = glm::vec4(o.dir, o.distance);
+        occluderAngles[i] = o.angle;
+    }
+
+    m_cullShader.use();
+    m_cullShader.setInt("uCount", (int)m_records.size());
+    m_cullShader.setInt("uPass", pass);
+    m_cullShader.setInt("uFirstCommand", pass * (int)m_meshes.size());
+    glUniform4fv(m_cullShader.uniformLocation("uPlanes"), 6, &frustum.planes[0].x);
+    m_cullShader.setInt("uOccluderCount", occluderCount);
+    if (occluderCount > 0)
+    {
+        m_cullShader.setVec3("uEye", occluders->eye());
+        glUniform4fv(m_cullShader.uniformLocation("uOccluders"), occluderCount, &occluderSpheres[0].x);
+        glUniform1fv(m_cullShader.uniformLocation("uOccluderAngles"), occluderCount, occluderAngles);
+    }
+
+    bindRecords();
+    glBindBufferRange(GL_SHADER_STORAGE_BUFFER, CANDIDATE_BINDING, m_stream.id(), (GLintptr)m_candidateOffset,
+                      (GLsizeiptr)(m_candidates.size() * sizeof(Candidate)));
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, COMMAND_BINDING, m_commandBuffer);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, VISIBLE_BINDING, m_visibleBuffer);
+    glDispatchCompute((GLuint)((m_records.size() + CULL_GROUP_SIZE - 1) / CULL_GROUP_SIZE), 1, 1);
+
+    // The counts feed the indirect draws, the visible list the vertex shader
+    glMemoryBarrier(GL_COMMAND_BARRIER_BIT | GL_SHADER_STORAGE_BARRIER_BIT);
+}
+
+void IndirectRenderer::bindRecords() const
+{
+    glBindBufferRange(GL_SHADER_STORAGE_BUFFER, DRAW_RECORD_BINDING, m_stream.id(), (GLintptr)m_recordOffset,
+                      (GLsizeiptr)(m_records.size() * sizeof(SphereInstance)));
+}
+
+void IndirectRenderer::draw(int pass) const
+{
+    if (m_records.empty())
+        return;
+
+    size_t meshCount = m_meshes.size();
+    bindRecords();
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, VISIBLE_BINDING, m_visibleBuffer);
+    glBindBuffer(GL_DRAW_INDIRECT_BUFFER, m_commandBuffer);
+    GLState::bindVertexArray(m_vao);
+    glMultiDrawElementsIndirect(GL_TRIANGLES, GL_UNSIGNED_INT, (void *)(pass * meshCount * sizeof(Command)),
+                                (GLsizei)meshCount, 0);
+    glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+}
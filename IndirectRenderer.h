@@ -0,0 +1,100 @@
+#ifndef INDIRECTRENDERER_H
+#define INDIRECTRENDERER_H
+
+#include <vector>
+#include <cstddef>
+#include <GL/glew.h>
+#include "SphereBatch.h"
+#include "FrustumCuller.h"
+#include "SphereOccluders.h"
+#include "Shader.h"
+#include "StreamBuffer.h"
+
+// GPU-driven submission: every mesh lives in one vertex/index arena and every
+// object is a candidate with a bounding sphere. A compute shader culls the
+// candidates per pass and writes the indirect commands' instance counts and a
+// list of visible records, so each pass goes out as one
+// glMultiDrawElementsIndirect with no CPU culling and no readback.
+// Needs GL 4.3 and ARB_shader_draw_parameters (Mesa llvmpipe has both).
+//
+// Known limit: the CPU still touches every object each frame. The caller
+// re-adds all candidates (after its own LOD selection), upload() counts their
+// command slots and streams every record and candidate again, so CPU cost is
+// O(objects) rather than constant. Keeping records resident and updating
+// transforms on the GPU would remove that; it is not done here.
+class IndirectRenderer
+{
+public:
+    // Storage block bindings shared with indirect_*.glsl
+    static const GLuint DRAW_RECORD_BINDING = 0;
+    static const GLuint CANDIDATE_BINDING = 1;
+    static const GLuint COMMAND_BINDING = 2;
+    static const GLuint VISIBLE_BINDING = 3;
+    // Occluders the cull shader tests against (the Sun and the planets fit)
+    static const int MAX_OCCLUDERS = 16;
+
+    static bool supported();
+
+    IndirectRenderer();
+    ~IndirectRenderer();
+
+    // Geometry is 8 floats per vertex (pos, normal, uv). Returns the mesh id.
+    int addMesh(const float *vertices, size_t vertexCount, const unsigned int *indices, size_t indexCount);
+    // Upload the arena and finish the cull program; no meshes can be added afterwards
+    void finalize();
+
+    void clear();
+    // `bounds` is xyz center, w radius. `passMask` has bit (1 << SpherePass) set
+    // for each pass the object may be drawn in.
+    void add(int mesh, const SphereInstance &instance, const glm::vec4 &bounds, unsigned int passMask);
+    // Upload the candidates and reset every command's instance count
+    void upload();
+    // Cull every candidate of `pass` on the GPU, minus those behind `occluders`
+    void cull(int pass, const Frustum &frustum, const SphereOccluders *occluders = nullptr);
+    // One multi-draw for `pass` with an indirect_*vertex.glsl program current
+    void draw(int pass) const;
+
+    int candidateCount() const { return (int)m_records.size(); }
+
+private:
+    struct Command
+    {
+        GLuint count;
+        GLuint instanceCount;
+        GLuint firstIndex;
+        GLint baseVertex;
+        GLuint baseInstance; // first slot of this command in the visible list
+    };
+    struct Candidate
+    {
+        glm::vec4 bounds;
+        GLuint mesh;
+        GLuint passMask;
+        GLuint pad0, pad1;
+    };
+    struct MeshRange
+    {
+        GLuint firstIndex;
+        GLuint indexCount;
+        GLint baseVertex;
+    };
+
+    Shader m_cullShader;
+    GLuint m_vao = 0, m_vbo = 0, m_ebo = 0;
+    GLuint m_commandBuffer = 0, m_visibleBuffer = 0;
+    size_t m_visibleCapacity = 0;
+    // Records and candidates are rewritten every frame
+    StreamBuffer m_stream;
+    GLint m_storageAlignment = 16;
+    size_t m_recordOffset = 0, m_candidateOffset = 0;
+    std::vector<float> m_vertices;
+    std::vector<unsigned int> m_indices;
+    std::vector<MeshRange> m_meshes;
+    std::vector<SphereInstance> m_records; // std430 layout matches SphereInstance
+    std::vector<Candidate> m_candidates;
+    std::vector<Command> m_commands; // SPHERE_PASS_COUNT groups of one command per mesh
+
+    void bindRecords() const;
+};
+
+#endif
@@ -1,9 +1,11 @@
 #include "Model.h"
+#include "GLState.h"
 #include <glm/gtc/matrix_transform.hpp>
 #include <fstream>
 #include <sstream>
 #include <unordered_map>
 #include <limits>
+#include <algorithm>
 
 ObjModel::~ObjModel()
 {
@@ -194,10 +196,20 @@ bool ObjModel::uploadToGPU()
     glEnableVertexAttribArray(2);
 
     glBindVertexArray(0);
+
+    m_localRadius = 0.0f;
+    for (const Vertex &v : m_vertices)
+        m_localRadius = std::max(m_localRadius, glm::length(v.pos));
+
     m_ready = true;
     return true;
 }
 
+float ObjModel::boundingRadius() const
+{
+    return m_localRadius * std::max(m_scale.x, std::max(m_scale.y, m_scale.z));
+}
+
 glm::mat4 ObjModel::modelMatrix() const
 {
     glm::mat4 m(1.0f);
@@ -213,7 +225,6 @@ void ObjModel::draw() const
 {
     if (!m_ready)
         return;
-    glBindVertexArray(m_vao);
+    GLState::bindVertexArray(m_vao);
     glDrawElements(GL_TRIANGLES, (GLsizei)m_indices.size(), GL_UNSIGNED_INT, 0);
-    glBindVertexArray(0);
 }
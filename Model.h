@@ -29,6 +29,14 @@ public:
 
     bool isReady() const { return m_ready; }
 
+    // Bounding sphere radius around the model origin, in world units (includes scale)
+    float boundingRadius() const;
+
+    // CPU geometry: 8 floats per vertex (pos, normal, uv), 32-bit indices
+    const float *vertexData() const { return m_vertices.empty() ? nullptr : &m_vertices[0].pos.x; }
+    size_t vertexCount() const { return m_vertices.size(); }
+    const std::vector<unsigned int> &indices() const { return m_indices; }
+
 private:
     struct Vertex
     {
@@ -42,6 +50,7 @@ private:
 
     GLuint m_vao = 0, m_vbo = 0, m_ebo = 0;
     bool m_ready = false;
+    float m_localRadius = 0.0f;
 
     glm::vec3 m_position{0.0f};
     glm::vec3 m_rotation{0.0f}; // radians (x,y,z)
@@ -25,23 +25,6 @@ void Moon::update(float deltaTime)
     m_rotation.y = m_time * m_rotationSpeed;
 }
 
-void Moon::render(Shader &shader, unsigned int sphereVAO, int vertexCount)
-{
-    if (m_texture)
-    {
-        glActiveTexture(GL_TEXTURE0);
-        m_texture->bind();
-        shader.setInt("texture1", 0);
-    }
-
-    // Set model matrix
-    shader.setMat4("model", getModelMatrix());
-
-    // Render the moon
-    glBindVertexArray(sphereVAO);
-    glDrawArrays(GL_TRIANGLES, 0, vertexCount);
-}
-
 glm::mat4 Moon::getModelMatrix() const
 {
     glm::mat4 model = glm::mat4(1.0f);
@@ -13,7 +13,6 @@ public:
          Planet *parentPlanet, float orbitRadius, float orbitSpeed);
 
     void update(float deltaTime) override;
-    void render(Shader &shader, unsigned int sphereVAO, int vertexCount) override;
     glm::mat4 getModelMatrix() const override;
 
 private:
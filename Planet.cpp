@@ -29,38 +29,20 @@ void Planet::update(float deltaTime)
         moon->update(deltaTime);
 }
 
-void Planet::render(Shader &shader, unsigned int sphereVAO, int vertexCount)
+glm::mat4 Planet::getModelMatrix() const
 {
-    if (m_texture)
-    {
-        glActiveTexture(GL_TEXTURE0);
-        m_texture->bind();
-        shader.setInt("texture1", 0);
-    }
-
-    // Selection highlight: slight scale up
-    float scaleBoost = m_selected ? 1.15f : 1.0f;
-
     glm::mat4 model = glm::mat4(1.0f);
     model = glm::translate(model, m_position);
     model = glm::rotate(model, m_rotation.y, glm::vec3(0.0f, 1.0f, 0.0f));
-    model = glm::scale(model, glm::vec3(m_radius * scaleBoost));
-    shader.setMat4("model", model);
-
-    glBindVertexArray(sphereVAO);
-    glDrawArrays(GL_TRIANGLES, 0, vertexCount);
-
-    for (auto &moon : m_moons)
-        moon->render(shader, sphereVAO, vertexCount);
+    model = glm::scale(model, glm::vec3(getScale()));
+    return model;
 }
 
-glm::mat4 Planet::getModelMatrix() const
+float Planet::getScale() const
 {
-    glm::mat4 model = glm::mat4(1.0f);
-    model = glm::translate(model, m_position);
-    model = glm::rotate(model, m_rotation.y, glm::vec3(0.0f, 1.0f, 0.0f));
-    model = glm::scale(model, glm::vec3(m_radius));
-    return model;
+    // Selection highlight: slight scale up
+    float scaleBoost = m_selected ? 1.15f : 1.0f;
+    return m_radius * scaleBoost;
 }
 
 void Planet::addMoon(std::shared_ptr<Moon> moon)
@@ -108,31 +90,3 @@ const std::string &Planet::currentFact() const
         return m_facts.front();
     return m_facts[m_lastFactIndex];
 }
-
-// Ray–sphere intersection against this planet's bounding sphere
-bool Planet::intersectsRay(const glm::vec3 &rayOrigin, const glm::vec3 &rayDir, float &tOut) const
-{
-    glm::vec3 oc = rayOrigin - m_position;
-    float a = glm::dot(rayDir, rayDir); // should be 1 if dir normalized
-    float b = 2.0f * glm::dot(oc, rayDir);
-    float c = glm::dot(oc, oc) - (m_radius * m_radius);
-
-    float discriminant = b * b - 4 * a * c;
-    if (discriminant < 0.0f)
-        return false;
-
-    float sqrtD = sqrtf(discriminant);
-    float t1 = (-b - sqrtD) / (2.0f * a);
-    float t2 = (-b + sqrtD) / (2.0f * a);
-
-    float t = std::numeric_limits<float>::infinity();
-    if (t1 > 0.0f)
-        t = t1;
-    if (t2 > 0.0f && t2 < t)
-        t = t2;
-
-    if (std::isinf(t))
-        return false;
-    tOut = t;
-    return true;
-}
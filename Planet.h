@@ -18,8 +18,8 @@ public:
            const std::vector<std::string> &facts = {});
 
     void update(float deltaTime) override;
-    void render(Shader &shader, unsigned int sphereVAO, int vertexCount) override;
     glm::mat4 getModelMatrix() const override;
+    float getScale() const override;
 
     // Moon management
     void addMoon(std::shared_ptr<Moon> moon);
@@ -38,9 +38,6 @@ public:
     // Returns the currently chosen fact (or the first if none chosen yet)
     const std::string &currentFact() const;
 
-    // Picking
-    bool intersectsRay(const glm::vec3 &rayOrigin, const glm::vec3 &rayDir, float &tOut) const;
-
 private:
     float m_orbitRadius;
     float m_orbitSpeed;
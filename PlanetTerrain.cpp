@@ -0,0 +1,363 @@
+#include "PlanetTerrain.h"
+#include "GLState.h"
+#include <glm/gtc/constants.hpp>
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <iterator>
+
+// Vertices along a chunk edge (16x16 quads), plus a skirt strip under each edge
+// that hides the cracks between neighbours of different levels.
+static const int GRID = 17;
+static const int CHUNK_VERTS = GRID * GRID + 4 * GRID;
+static const int FLOATS_PER_VERTEX = 8;
+static const size_t CHUNK_BYTES = CHUNK_VERTS * FLOATS_PER_VERTEX * sizeof(float);
+static const float SKIRT_DEPTH = 0.02f; // fraction of the radius
+
+static const int MAX_LEVEL = 16;
+static const float SPLIT_ERROR_PX = 0.5f;
+static const int MAX_UPLOADS_PER_FRAME = 16;
+static const size_t MAX_PENDING = 64;
+static const size_t MIN_SLOTS = 64;
+
+// Normal, u axis, v axis of each cube face
+static const glm::vec3 FACE_AXES[6][3] = {
+    {glm::vec3(1, 0, 0), glm::vec3(0, 0, -1), glm::vec3(0, 1, 0)},
+    {glm::vec3(-1, 0, 0), glm::vec3(0, 0, 1), glm::vec3(0, 1, 0)},
+    {glm::vec3(0, 1, 0), glm::vec3(1, 0, 0), glm::vec3(0, 0, -1)},
+    {glm::vec3(0, -1, 0), glm::vec3(1, 0, 0), glm::vec3(0, 0, 1)},
+    {glm::vec3(0, 0, 1), glm::vec3(1, 0, 0), glm::vec3(0, 1, 0)},
+    {glm::vec3(0, 0, -1), glm::vec3(-1, 0, 0), glm::vec3(0, 1, 0)}};
+
+// Grid vertex at position k along edge e (0 = bottom, 1 = right, 2 = top, 3 = left)
+static int edgeVertex(int e, int k)
+{
+    switch (e)
+    {
+    case 0:
+        return k;
+    case 1:
+        return k * GRID + GRID - 1;
+    case 2:
+        return (GRID - 1) * GRID + k;
+    default:
+        return k * GRID;
+    }
+}
+
+PlanetTerrain::PlanetTerrain(size_t memoryBudgetBytes, unsigned workerThreads)
+    : m_pool(workerThreads)
+{
+    size_t slotCount = std::max(memoryBudgetBytes / CHUNK_BYTES, MIN_SLOTS);
+    m_slots.resize(slotCount);
+    for (size_t i = slotCount; i-- > 0;)
+        m_freeSlots.push_back((int)i);
+
+    // Every chunk shares one index topology; slots differ only by base vertex
+    std::vector<unsigned short> indices;
+    for (int j = 0; j < GRID - 1; ++j)
+    {
+        for (int i = 0; i < GRID - 1; ++i)
+        {
+            unsigned short a = (unsigned short)(j * GRID + i);
+            unsigned short b = (unsigned short)(a + 1);
+            unsigned short c = (unsigned short)(a + GRID);
+            unsigned short d = (unsigned short)(c + 1);
+            indices.insert(indices.end(), {a, b, d, a, d, c});
+        }
+    }
+    for (int e = 0; e < 4; ++e)
+    {
+        for (int k = 0; k < GRID - 1; ++k)
+        {
+            unsigned short top0 = (unsigned short)edgeVertex(e, k);
+            unsigned short top1 = (unsigned short)edgeVertex(e, k + 1);
+            unsigned short bot0 = (unsigned short)(GRID * GRID + e * GRID + k);
+            unsigned short bot1 = (unsigned short)(bot0 + 1);
+            indices.insert(indices.end(), {top0, bot0, bot1, top0, bot1, top1});
+        }
+    }
+    m_indexCount = (GLsizei)indices.size();
+
+    glGenVertexArrays(1, &m_vao);
+    glGenBuffers(1, &m_vbo);
+    glGenBuffers(1, &m_ebo);
+    glGenBuffers(1, &m_instanceVBO);
+
+    glBindVertexArray(m_vao);
+    glBindBuffer(GL_ARRAY_BUFFER, m_vbo);
+    glBufferData(GL_ARRAY_BUFFER, slotCount * CHUNK_BYTES, nullptr, GL_DYNAMIC_DRAW);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_ebo);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(unsigned short), indices.data(), GL_STATIC_DRAW);
+
+    // Same layout as SphereMesh, so the sphere shaders draw chunks unchanged
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void *)0);
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void *)(3 * sizeof(float)));
+    glEnableVertexAttribArray(1);
+    glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void *)(6 * sizeof(float)));
+    glEnableVertexAttribArray(2);
+
+    // A single SphereInstance for the body the terrain currently stands in for
+    glBindBuffer(GL_ARRAY_BUFFER, m_instanceVBO);
+    glBufferData(GL_ARRAY_BUFFER, sizeof(SphereInstance), nullptr, GL_DYNAMIC_DRAW);
+    for (int col = 0; col < 4; ++col)
+    {
+        glVertexAttribPointer(3 + col, 4, GL_FLOAT, GL_FALSE, sizeof(SphereInstance),
+                              (void *)(offsetof(SphereInstance, model) + col * sizeof(glm::vec4)));
+        glEnableVertexAttribArray(3 + col);
+        glVertexAttribDivisor(3 + col, 1);
+    }
+    glVertexAttribPointer(7, 4, GL_FLOAT, GL_FALSE, sizeof(SphereInstance), (void *)offsetof(SphereInstance, params));
+    glEnableVertexAttribArray(7);
+    glVertexAttribDivisor(7, 1);
+    for (int col = 0; col < 3; ++col)
+    {
+        glVertexAttribPointer(8 + col, 3, GL_FLOAT, GL_FALSE, sizeof(SphereInstance),
+                              (void *)(offsetof(SphereInstance, normal) + col * sizeof(glm::vec4)));
+        glEnableVertexAttribArray(8 + col);
+        glVertexAttribDivisor(8 + col, 1);
+    }
+    glBindVertexArray(0);
+}
+
+PlanetTerrain::~PlanetTerrain()
+{
+    if (m_instanceVBO)
+        glDeleteBuffers(1, &m_instanceVBO);
+    if (m_ebo)
+        glDeleteBuffers(1, &m_ebo);
+    if (m_vbo)
+        glDeleteBuffers(1, &m_vbo);
+    if (m_vao)
+        glDeleteVertexArrays(1, &m_vao);
+}
+
+uint64_t PlanetTerrain::packKey(const Node &n)
+{
+    return ((uint64_t)n.face << 56) | ((uint64_t)n.level << 48) | ((uint64_t)n.x << 24) | (uint64_t)n.y;
+}
+
+glm::vec3 PlanetTerrain::cubeToSphere(int face, float s, float t)
+{
+    const glm::vec3 *axes = FACE_AXES[face];
+    return glm::normalize(axes[0] + (2.0f * s - 1.0f) * axes[1] + (2.0f * t - 1.0f) * axes[2]);
+}
+
+void PlanetTerrain::buildChunk(const Node &n, std::vector<float> &out)
+{
+    const float twoPi = 2.0f * glm::pi<float>();
+    float size = 1.0f / (float)(1 << n.level);
+    float s0 = n.x * size, t0 = n.y * size;
+
+    // u is taken from the copy nearest the chunk centre, so chunks across the
+    // texture seam stay continuous (the array sampler repeats in u)
+    glm::vec3 centerDir = cubeToSphere(n.face, s0 + 0.5f * size, t0 + 0.5f * size);
+    float centerU = std::atan2(centerDir.y, centerDir.x) / twoPi;
+
+    std::vector<glm::vec3> dirs(GRID * GRID);
+    for (int j = 0; j < GRID; ++j)
+        for (int i = 0; i < GRID; ++i)
+            dirs[j * GRID + i] = cubeToSphere(n.face, s0 + size * i / (GRID - 1), t0 + size * j / (GRID - 1));
+
+    out.clear();
+    out.reserve(CHUNK_VERTS * FLOATS_PER_VERTEX);
+    auto emit = [&](const glm::vec3 &dir, float scale)
+    {
+        // Same mapping as SphereMesh: u around the z axis, v from the +z pole
+        float u = centerU;
+        if (dir.x * dir.x + dir.y * dir.y > 1e-12f)
+        {
+            u = std::atan2(dir.y, dir.x) / twoPi;
+            u += std::round(centerU - u);
+        }
+        float v = std::acos(std::min(std::max(dir.z, -1.0f), 1.0f)) / glm::pi<float>();
+        glm::vec3 pos = dir * scale;
+        out.insert(out.end(), {pos.x, pos.y, pos.z, dir.x, dir.y, dir.z, u, v});
+    };
+
+    for (const glm::vec3 &dir : dirs)
+        emit(dir, 1.0f);
+    for (int e = 0; e < 4; ++e)
+        for (int k = 0; k < GRID; ++k)
+            emit(dirs[edgeVertex(e, k)], 1.0f - SKIRT_DEPTH);
+}
+
+bool PlanetTerrain::isReady(const Node &n)
+{
+    auto it = m_slotOf.find(packKey(n));
+    if (it == m_slotOf.end())
+        return false;
+    m_slots[it->second].lastFrame = m_frame;
+    return true;
+}
+
+void PlanetTerrain::request(const Node &n)
+{
+    uint64_t key = packKey(n);
+    if (m_pending.size() >= MAX_PENDING || m_pending.count(key))
+        return;
+    m_pending.insert(key);
+
+    m_pool.submit([this, n, key]()
+    {
+        ChunkData chunk{key, {}};
+        buildChunk(n, chunk.vertices);
+        std::lock_guard<std::mutex> lock(m_readyMutex);
+        m_ready.push_back(std::move(chunk));
+    });
+}
+
+bool PlanetTerrain::upload(const ChunkData &chunk)
+{
+    int slot = -1;
+    if (!m_freeSlots.empty())
+    {
+        slot = m_freeSlots.back();
+        m_freeSlots.pop_back();
+    }
+    else
+    {
+        // Evict the least recently drawn chunk, never one used this frame
+        uint64_t oldest = m_frame;
+        for (int i = 0; i < (int)m_slots.size(); ++i)
+        {
+            if (m_slots[i].lastFrame < oldest)
+            {
+                oldest = m_slots[i].lastFrame;
+                slot = i;
+            }
+        }
+        if (slot < 0)
+            return false;
+        m_slotOf.erase(m_slots[slot].key);
+    }
+
+    m_slots[slot].key = chunk.key;
+    m_slots[slot].lastFrame = m_frame;
+    m_slotOf[chunk.key] = slot;
+
+    glBindBuffer(GL_ARRAY_BUFFER, m_vbo);
+    glBufferSubData(GL_ARRAY_BUFFER, slot * CHUNK_BYTES, CHUNK_BYTES, chunk.vertices.data());
+    return true;
+}
+
+void PlanetTerrain::uploadReady()
+{
+    std::vector<ChunkData> ready;
+    {
+        std::lock_guard<std::mutex> lock(m_readyMutex);
+        size_t n = std::min(m_ready.size(), (size_t)MAX_UPLOADS_PER_FRAME);
+        std::move(m_ready.begin(), m_ready.begin() + n, std::back_inserter(ready));
+        m_ready.erase(m_ready.begin(), m_ready.begin() + n);
+    }
+
+    // A chunk that finds no slot is dropped and requested again when still needed
+    for (const ChunkData &chunk : ready)
+    {
+        m_pending.erase(chunk.key);
+        upload(chunk);
+    }
+}
+
+void PlanetTerrain::select(const Node &n, const glm::vec3 &eyeLocal, float pixelScale)
+{
+    float size = 1.0f / (float)(1 << n.level);
+    glm::vec3 center = cubeToSphere(n.face, (n.x + 0.5f) * size, (n.y + 0.5f) * size);
+
+    // Angular radius of the chunk: its widest corner
+    float cosAlpha = 1.0f;
+    for (int c = 0; c < 4; ++c)
+    {
+        glm::vec3 corner = cubeToSphere(n.face, (n.x + (c & 1)) * size, (n.y + (c >> 1)) * size);
+        cosAlpha = std::min(cosAlpha, glm::dot(center, corner));
+    }
+    float alpha = std::acos(std::min(std::max(cosAlpha, -1.0f), 1.0f));
+
+    // Skip chunks entirely behind the limb
+    float eyeDist = glm::length(eyeLocal);
+    if (eyeDist > 1.0f)
+    {
+        float toEye = std::acos(std::min(std::max(glm::dot(center, eyeLocal / eyeDist), -1.0f), 1.0f));
+        if (toEye - alpha > std::acos(1.0f / eyeDist))
+            return;
+    }
+
+    // Screen-space error: sagitta of one grid segment over the distance to the
+    // chunk's bounding sphere. The body radius cancels out in unit-sphere space.
+    float dist = std::max(glm::length(eyeLocal - center) - 2.0f * std::sin(0.5f * alpha), 1e-4f);
+    float segment = 2.0f * alpha / (GRID - 1);
+    float errorPx = (1.0f - std::cos(0.5f * segment)) / dist * pixelScale;
+
+    if (n.level < MAX_LEVEL && errorPx > SPLIT_ERROR_PX)
+    {
+        Node kids[4];
+        bool kidsReady = true;
+        for (int c = 0; c < 4; ++c)
+        {
+            kids[c] = Node{n.face, n.level + 1, 2 * n.x + (c & 1), 2 * n.y + (c >> 1)};
+            if (!isReady(kids[c]))
+            {
+                request(kids[c]);
+                kidsReady = false;
+            }
+        }
+        if (kidsReady)
+        {
+            for (const Node &kid : kids)
+                select(kid, eyeLocal, pixelScale);
+            return;
+        }
+    }
+
+    // This node stands in until all four children have arrived
+    m_drawList.push_back(m_slotOf[packKey(n)]);
+}
+
+void PlanetTerrain::update(const CelestialBody &body, const glm::vec3 &eye, float pixelScale)
+{
+    ++m_frame;
+
+    glm::mat4 model = body.getModelMatrix();
+    glm::vec3 eyeLocal = glm::vec3(glm::inverse(model) * glm::vec4(eye, 1.0f));
+
+    m_drawList.clear();
+    for (int face = 0; face < 6; ++face)
+    {
+        // Roots are built inline so there is always something to draw
+        Node root{face, 0, 0, 0};
+        if (!isReady(root))
+        {
+            ChunkData chunk{packKey(root), {}};
+            buildChunk(root, chunk.vertices);
+            if (!upload(chunk))
+                continue;
+        }
+        select(root, eyeLocal, pixelScale);
+    }
+
+    // Uploads go after selection so eviction never hits a chunk drawn this frame
+    uploadReady();
+
+    m_counts.assign(m_drawList.size(), m_indexCount);
+    m_offsets.assign(m_drawList.size(), nullptr);
+    m_baseVertices.resize(m_drawList.size());
+    for (size_t i = 0; i < m_drawList.size(); ++i)
+        m_baseVertices[i] = m_drawList[i] * CHUNK_VERTS;
+
+    SphereInstance instance{model, glm::vec4((float)body.getTextureLayer(), (float)body.sphereFlags(), 0.0f, 0.0f),
+                            NormalMatrix::fromModel(model)};
+    glBindBuffer(GL_ARRAY_BUFFER, m_instanceVBO);
+    glBufferSubData(GL_ARRAY_BUFFER, 0, sizeof(SphereInstance), &instance);
+}
+
+void PlanetTerrain::draw() const
+{
+    if (m_drawList.empty())
+        return;
+
+    // Non-instanced draws read instance 0 of the divisor-1 attributes
+    GLState::bindVertexArray(m_vao);
+    glMultiDrawElementsBaseVertex(GL_TRIANGLES, m_counts.data(), GL_UNSIGNED_SHORT, m_offsets.data(),
+                                  (GLsizei)m_drawList.size(), m_baseVertices.data());
+}
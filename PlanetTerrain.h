@@ -0,0 +1,85 @@
+#ifndef PLANETTERRAIN_H
+#define PLANETTERRAIN_H
+
+#include <vector>
+#include <unordered_map>
+#include <unordered_set>
+#include <mutex>
+#include <cstdint>
+#include <glm/glm.hpp>
+#include <GL/glew.h>
+#include "CelestialBody.h"
+#include "SphereBatch.h"
+#include "ThreadPool.h"
+
+// Chunked quadtree cube-sphere used in place of the UV sphere when the camera
+// is close to a body. Each cube face is a quadtree; nodes split while their
+// screen-space error is above a pixel threshold. Chunk meshes are built on
+// worker threads in unit-sphere space, so one cache serves every body, and
+// live in fixed-size slots of a single VBO capped by a memory budget.
+class PlanetTerrain
+{
+public:
+    explicit PlanetTerrain(size_t memoryBudgetBytes = 32u << 20, unsigned workerThreads = 2);
+    ~PlanetTerrain();
+
+    // Pick the chunks to draw for `body` seen from `eye`, queue missing ones and
+    // upload finished ones. Call once per frame before drawing.
+    void update(const CelestialBody &body, const glm::vec3 &eye, float pixelScale);
+
+    // Draw the selected chunks with whichever sphere program is bound
+    // (instanced lit sphere permutation or shadow shader).
+    void draw() const;
+
+    int chunksDrawn() const { return (int)m_drawList.size(); }
+    int chunksCached() const { return (int)m_slotOf.size(); }
+    int chunksPending() const { return (int)m_pending.size(); }
+
+private:
+    struct Node
+    {
+        int face, level, x, y;
+    };
+
+    struct ChunkData
+    {
+        uint64_t key;
+        std::vector<float> vertices;
+    };
+
+    struct Slot
+    {
+        uint64_t key = 0;
+        uint64_t lastFrame = 0;
+    };
+
+    GLuint m_vao = 0, m_vbo = 0, m_ebo = 0, m_instanceVBO = 0;
+    GLsizei m_indexCount = 0;
+    std::vector<Slot> m_slots;
+    std::vector<int> m_freeSlots;
+    std::unordered_map<uint64_t, int> m_slotOf;
+    std::unordered_set<uint64_t> m_pending;
+    std::vector<int> m_drawList; // slots, this frame
+    std::vector<GLsizei> m_counts;
+    std::vector<const void *> m_offsets;
+    std::vector<GLint> m_baseVertices;
+    uint64_t m_frame = 0;
+
+    std::mutex m_readyMutex;
+    std::vector<ChunkData> m_ready;
+
+    // Declared last: joins its workers before the members above go away
+    ThreadPool m_pool;
+
+    static uint64_t packKey(const Node &n);
+    static void buildChunk(const Node &n, std::vector<float> &out);
+    static glm::vec3 cubeToSphere(int face, float s, float t);
+
+    void uploadReady();
+    bool upload(const ChunkData &chunk);
+    bool isReady(const Node &n);
+    void request(const Node &n);
+    void select(const Node &n, const glm::vec3 &eyeLocal, float pixelScale);
+};
+
+#endif
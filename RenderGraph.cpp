@@ -0,0 +1,296 @@
+#include "RenderGraph.h"
+#include "GLState.h"
+#include <algorithm>
+#include <iostream>
+
+static bool isDepthFormat(GLenum format)
+{
+    return format == GL_DEPTH_COMPONENT || format == GL_DEPTH_COMPONENT16 || format == GL_DEPTH_COMPONENT24 ||
+           format == GL_DEPTH_COMPONENT32 || format == GL_DEPTH_COMPONENT32F;
+}
+
+RenderGraph::~RenderGraph()
+{
+    for (auto &entry : m_fbos)
+        glDeleteFramebuffers(1, &entry.second);
+    for (PooledTexture &pooled : m_pool)
+        glDeleteTextures(1, &pooled.texture);
+    for (PassTimer &timer : m_timers)
+        glDeleteQueries(QUERY_FRAMES, timer.queries);
+}
+
+void RenderGraph::reset()
+{
+    m_resources.clear();
+    m_passes.clear();
+}
+
+RenderGraph::Resource RenderGraph::importBackbuffer()
+{
+    ResourceNode node;
+    node.name = "backbuffer";
+    node.imported = true;
+    m_resources.push_back(node);
+    return (Resource)m_resources.size() - 1;
+}
+
+RenderGraph::Resource RenderGraph::createTexture(const char *name, const RenderTargetDesc &desc)
+{
+    ResourceNode node;
+    node.name = name;
+    node.desc = desc;
+    m_resources.push_back(node);
+    return (Resource)m_resources.size() - 1;
+}
+
+int RenderGraph::addPass(const char *name, std::function<void()> execute)
+{
+    PassNode node;
+    node.name = name;
+    node.execute = std::move(execute);
+    m_passes.push_back(std::move(node));
+    return (int)m_passes.size() - 1;
+}
+
+void RenderGraph::read(int pass, Resource resource)
+{
+    m_passes[pass].reads.push_back(resource);
+}
+
+void RenderGraph::write(int pass, Resource resource)
+{
+    m_passes[pass].writes.push_back(resource);
+}
+
+void RenderGraph::compile()
+{
+    // Passes are declared in execution order, so one backward sweep finds
+    // everything that feeds the backbuffer
+    std::vector<bool> needed(m_resources.size(), false);
+    for (size_t r = 0; r < m_resources.size(); ++r)
+        needed[r] = m_resources[r].imported;
+    for (int p = (int)m_passes.size() - 1; p >= 0; --p)
+    {
+        PassNode &pass = m_passes[p];
+        pass.live = false;
+        for (Resource r : pass.writes)
+            pass.live = pass.live || needed[r];
+        if (pass.live)
+            for (Resource r : pass.reads)
+                needed[r] = true;
+    }
+
+    // Lifetime of each transient over the live passes
+    std::vector<int> first(m_resources.size(), -1), last(m_resources.size(), -1);
+    for (int p = 0; p < (int)m_passes.size(); ++p)
+    {
+        if (!m_passes[p].live)
+            continue;
+        auto touch = [&](Resource r)
+        {
+            if (first[r] < 0)
+                first[r] = p;
+            last[r] = p;
+        };
+        for (Resource r : m_passes[p].reads)
+            touch(r);
+        for (Resource r : m_passes[p].writes)
+            touch(r);
+    }
+
+    // Hand out pooled textures in order of first use; one whose last user
+    // runs before a resource's first user can be aliased
+    std::vector<Resource> order;
+    for (size_t r = 0; r < m_resources.size(); ++r)
+    {
+        m_resources[r].physical = -1;
+        if (!m_resources[r].imported && first[r] >= 0)
+            order.push_back((Resource)r);
+    }
+    std::sort(order.begin(), order.end(), [&](Resource a, Resource b) { return first[a] < first[b]; });
+    evictIdleTextures();
+    for (PooledTexture &pooled : m_pool)
+        pooled.busyUntil = -1;
+    for (Resource r : order)
+        m_resources[r].physical = acquireTexture(m_resources[r].desc, first[r], last[r]);
+
+    for (PassNode &pass : m_passes)
+        if (pass.live)
+            pass.fbo = framebufferFor(pass);
+}
+
+void RenderGraph::evictIdleTextures()
+{
+    // Nothing has been handed out yet this compile, so pool indices may shift
+    for (size_t i = 0; i < m_pool.size();)
+    {
+        if (m_frame - m_pool[i].lastFrame <= POOL_IDLE_FRAMES)
+        {
+            ++i;
+            continue;
+        }
+
+        GLuint texture = m_pool[i].texture;
+        for (auto it = m_fbos.begin(); it != m_fbos.end();)
+        {
+            if (std::find(it->first.begin(), it->first.end(), texture) != it->first.end())
+            {
+                glDeleteFramebuffers(1, &it->second);
+                it = m_fbos.erase(it);
+            }
+            else
+                ++it;
+        }
+        glDeleteTextures(1, &texture);
+        m_pool.erase(m_pool.begin() + i);
+    }
+}
+
+int RenderGraph::acquireTexture(const RenderTargetDesc &desc, int firstPass, int lastPass)
+{
+    for (size_t i = 0; i < m_pool.size(); ++i)
+    {
+        if (m_pool[i].desc == desc && m_pool[i].busyUntil < firstPass)
+        {
+            m_pool[i].busyUntil = lastPass;
+            m_pool[i].lastFrame = m_frame;
+            return (int)i;
+        }
+    }
+
+    PooledTexture pooled;
+    pooled.desc = desc;
+    pooled.busyUntil = lastPass;
+    pooled.lastFrame = m_frame;
+    glGenTextures(1, &pooled.texture);
+    GLState::bindTexture(GL_TEXTURE_2D, pooled.texture);
+    if (isDepthFormat(desc.internalFormat))
+    {
+        // Outside a depth target counts as lit when it is sampled as a shadow map
+        glTexImage2D(GL_TEXTURE_2D, 0, desc.internalFormat, desc.width, desc.height, 0, GL_DEPTH_COMPONENT, GL_FLOAT, NULL);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_BORDER);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_BORDER);
+        float borderColor[] = {1, 1, 1, 1};
+        glTexParameterfv(GL_TEXTURE_2D, GL_TEXTURE_BORDER_COLOR, borderColor);
+    }
+    else
+    {
+        glTexImage2D(GL_TEXTURE_2D, 0, desc.internalFormat, desc.width, desc.height, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    }
+    m_pool.push_back(pooled);
+    return (int)m_pool.size() - 1;
+}
+
+GLuint RenderGraph::framebufferFor(const PassNode &pass)
+{
+    std::vector<GLuint> attachments;
+    for (Resource r : pass.writes)
+    {
+        if (m_resources[r].imported)
+            return 0;
+        attachments.push_back(m_pool[m_resources[r].physical].texture);
+    }
+
+    auto it = m_fbos.find(attachments);
+    if (it != m_fbos.end())
+        return it->second;
+
+    GLuint fbo;
+    glGenFramebuffers(1, &fbo);
+    GLState::bindFramebuffer(fbo);
+    std::vector<GLenum> drawBuffers;
+    for (Resource r : pass.writes)
+    {
+        const PooledTexture &pooled = m_pool[m_resources[r].physical];
+        if (isDepthFormat(pooled.desc.internalFormat))
+        {
+            glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, pooled.texture, 0);
+        }
+        else
+        {
+            GLenum attachment = GL_COLOR_ATTACHMENT0 + (GLenum)drawBuffers.size();
+            glFramebufferTexture2D(GL_FRAMEBUFFER, attachment, GL_TEXTURE_2D, pooled.texture, 0);
+            drawBuffers.push_back(attachment);
+        }
+    }
+    if (drawBuffers.empty())
+    {
+        glDrawBuffer(GL_NONE);
+        glReadBuffer(GL_NONE);
+    }
+    else
+    {
+        glDrawBuffers((GLsizei)drawBuffers.size(), drawBuffers.data());
+    }
+    if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+        std::cerr << "[RenderGraph] Incomplete framebuffer for pass " << pass.name << "\n";
+    GLState::bindFramebuffer(0);
+
+    m_fbos[attachments] = fbo;
+    return fbo;
+}
+
+RenderGraph::PassTimer &RenderGraph::timerFor(const std::string &name)
+{
+    for (PassTimer &timer : m_timers)
+        if (timer.name == name)
+            return timer;
+
+    PassTimer timer;
+    timer.name = name;
+    glGenQueries(QUERY_FRAMES, timer.queries);
+    m_timers.push_back(timer);
+    return m_timers.back();
+}
+
+void RenderGraph::execute()
+{
+    int slot = (int)(m_frame % QUERY_FRAMES);
+    m_timings.clear();
+
+    for (PassNode &pass : m_passes)
+    {
+        PassTimer &timer = timerFor(pass.name);
+
+        // Collect the result this slot held from QUERY_FRAMES frames ago
+        if (timer.pending[slot])
+        {
+            GLint available = 0;
+            glGetQueryObjectiv(timer.queries[slot], GL_QUERY_RESULT_AVAILABLE, &available);
+            if (available)
+            {
+                GLuint64 ns = 0;
+                glGetQueryObjectui64v(timer.queries[slot], GL_QUERY_RESULT, &ns);
+                timer.ms = (float)(ns / 1.0e6);
+            }
+            timer.pending[slot] = false;
+        }
+
+        if (pass.live)
+        {
+            GLState::bindFramebuffer(pass.fbo);
+            glBeginQuery(GL_TIME_ELAPSED, timer.queries[slot]);
+            if (pass.execute)
+                pass.execute();
+            glEndQuery(GL_TIME_ELAPSED);
+            timer.pending[slot] = true;
+        }
+
+        m_timings.push_back(PassTiming{pass.name, timer.ms, !pass.live});
+    }
+
+    GLState::bindFramebuffer(0);
+    ++m_frame;
+}
+
+GLuint RenderGraph::texture(Resource resource) const
+{
+    int physical = m_resources[resource].physical;
+    return physical >= 0 ? m_pool[physical].texture : 0;
+}
@@ -0,0 +1,114 @@
+#ifndef RENDERGRAPH_H
+#define RENDERGRAPH_H
+
+#include <map>
+#include <string>
+#include <vector>
+#include <functional>
+#include <GL/glew.h>
+
+struct RenderTargetDesc
+{
+    GLsizei width = 0, height = 0;
+    GLenum internalFormat = GL_RGBA8; // depth formats become depth attachments
+
+    bool operator==(const RenderTargetDesc &o) const
+    {
+        return width == o.width && height == o.height && internalFormat == o.internalFormat;
+    }
+};
+
+// A frame described as passes that read and write named resources, rebuilt
+// every frame. compile() drops passes whose outputs nothing reads (walking
+// back from the backbuffer) and maps transient textures onto pooled GL
+// textures, so targets with disjoint lifetimes share memory; pooled textures
+// no frame has asked for in POOL_IDLE_FRAMES (old window sizes) are released.
+// execute() binds
+// each pass's framebuffer, runs it and times it with GL_TIME_ELAPSED queries
+// (read a few frames later, so the CPU never waits on them).
+class RenderGraph
+{
+public:
+    typedef int Resource;
+
+    struct PassTiming
+    {
+        std::string name;
+        float ms;    // GPU time, -1 until the first result arrives
+        bool culled; // this frame
+    };
+
+    ~RenderGraph();
+
+    // Forget this frame's passes and resources; pooled textures and FBOs stay
+    void reset();
+
+    // The default framebuffer; passes writing it are always kept
+    Resource importBackbuffer();
+    Resource createTexture(const char *name, const RenderTargetDesc &desc);
+
+    int addPass(const char *name, std::function<void()> execute);
+    void read(int pass, Resource resource);
+    void write(int pass, Resource resource);
+
+    void compile();
+    void execute();
+
+    // GL texture behind a transient resource; valid after compile(), 0 if unused
+    GLuint texture(Resource resource) const;
+    // Framebuffer a live pass renders into (0 for the backbuffer), e.g. to blit from
+    GLuint framebuffer(int pass) const { return m_passes[pass].fbo; }
+    bool culled(int pass) const { return !m_passes[pass].live; }
+
+    const std::vector<PassTiming> &timings() const { return m_timings; }
+    int pooledTextures() const { return (int)m_pool.size(); }
+
+private:
+    static const int QUERY_FRAMES = 3;
+    static const unsigned POOL_IDLE_FRAMES = 60;
+
+    struct ResourceNode
+    {
+        std::string name;
+        RenderTargetDesc desc;
+        bool imported = false;
+        int physical = -1; // index into m_pool
+    };
+    struct PassNode
+    {
+        std::string name;
+        std::function<void()> execute;
+        std::vector<Resource> reads, writes;
+        bool live = false;
+        GLuint fbo = 0;
+    };
+    struct PooledTexture
+    {
+        RenderTargetDesc desc;
+        GLuint texture = 0;
+        int busyUntil = -1; // last pass using it this frame
+        unsigned lastFrame = 0; // last frame that used it
+    };
+    struct PassTimer
+    {
+        std::string name;
+        GLuint queries[QUERY_FRAMES] = {};
+        bool pending[QUERY_FRAMES] = {};
+        float ms = -1.0f;
+    };
+
+    std::vector<ResourceNode> m_resources;
+    std::vector<PassNode> m_passes;
+    std::vector<PooledTexture> m_pool;
+    std::map<std::vector<GLuint>, GLuint> m_fbos; // attachment set -> framebuffer
+    std::vector<PassTimer> m_timers;
+    std::vector<PassTiming> m_timings;
+    unsigned m_frame = 0;
+
+    void evictIdleTextures();
+    int acquireTexture(const RenderTargetDesc &desc, int firstPass, int lastPass);
+    GLuint framebufferFor(const PassNode &pass);
+    PassTimer &timerFor(const std::string &name);
+};
+
+#endif
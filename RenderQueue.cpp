@@ -0,0 +1,123 @@
+#include "RenderQueue.h"
+#include "GLState.h"
+#include <algorithm>
+
+uint64_t RenderQueue::makeKey(const DrawPacket &packet)
+{
+    uint64_t program = packet.shader ? (packet.shader->ID & 0xffu) : 0u;
+    uint64_t depth = (uint64_t)(std::min(std::max(packet.depth, 0.0f), 1.0f) * 0xffffff);
+
+    return ((uint64_t)(packet.pass & 0xfu) << 60) | (program << 52) | ((uint64_t)(packet.texture & 0xfffu) << 40) |
+           ((uint64_t)(packet.mesh & 0xfffu) << 28) | (depth << 4);
+}
+
+void RenderQueue::clear()
+{
+    m_packets.clear();
+    m_keys.clear();
+}
+
+void RenderQueue::submit(const DrawPacket &packet)
+{
+    m_packets.push_back(packet);
+    m_keys.push_back(makeKey(packet));
+}
+
+void RenderQueue::setPassHooks(unsigned pass, std::function<void()> begin, std::function<void()> end)
+{
+    m_begin[pass] = std::move(begin);
+    m_end[pass] = std::move(end);
+}
+
+void RenderQueue::sort()
+{
+    // LSD radix sort on 8-bit digits, stable, carrying packet indices.
+    // Digits that are equal across every key (common: unused bits, few passes) are skipped.
+    size_t n = m_keys.size();
+    m_order.resize(n);
+    m_scratch.resize(n);
+    for (size_t i = 0; i < n; ++i)
+        m_order[i] = (uint32_t)i;
+
+    for (int shift = 0; shift < 64; shift += 8)
+    {
+        size_t count[256] = {};
+        for (size_t i = 0; i < n; ++i)
+            ++count[(m_keys[i] >> shift) & 0xff];
+        if (n == 0 || count[(m_keys[0] >> shift) & 0xff] == n)
+            continue;
+
+        size_t offset = 0;
+        for (size_t &c : count)
+        {
+            size_t next = offset + c;
+            c = offset;
+            offset = next;
+        }
+        for (size_t i = 0; i < n; ++i)
+        {
+            uint32_t idx = m_order[i];
+            m_scratch[count[(m_keys[idx] >> shift) & 0xff]++] = idx;
+        }
+        m_order.swap(m_scratch);
+    }
+}
+
+void RenderQueue::prepare()
+{
+    sort();
+
+    // Packets are grouped by pass after sorting; find where each group starts
+    size_t next = 0;
+    for (unsigned pass = 0; pass < RENDER_PASS_COUNT; ++pass)
+    {
+        m_passFirst[pass] = next;
+        while (next < m_order.size() && m_packets[m_order[next]].pass == pass)
+            ++next;
+    }
+    m_passFirst[RENDER_PASS_COUNT] = next;
+
+    m_programSwitches = m_textureSwitches = 0;
+    m_program = nullptr;
+    m_texture = 0;
+}
+
+void RenderQueue::executePass(unsigned pass)
+{
+    if (m_begin[pass])
+        m_begin[pass]();
+
+    for (size_t i = m_passFirst[pass]; i < m_passFirst[pass + 1]; ++i)
+    {
+        // Draw callbacks may bind things themselves, so always go through
+        // the (deduplicating) state cache; the counters compare packets only
+        const DrawPacket &packet = m_packets[m_order[i]];
+        if (packet.shader)
+        {
+            packet.shader->use();
+            if (packet.shader != m_program)
+                ++m_programSwitches;
+            m_program = packet.shader;
+        }
+        if (packet.texture)
+        {
+            GLState::activeTexture(GL_TEXTURE0);
+            GLState::bindTexture(packet.textureTarget, packet.texture);
+            if (packet.texture != m_texture)
+                ++m_textureSwitches;
+            m_texture = packet.texture;
+        }
+        if (packet.draw)
+            packet.draw();
+    }
+
+    if (m_end[pass])
+        m_end[pass]();
+}
+
+void RenderQueue::execute()
+{
+    prepare();
+    for (unsigned pass = 0; pass < RENDER_PASS_COUNT; ++pass)
+        executePass(pass);
+}
@@ -0,0 +1,69 @@
+#ifndef RENDERQUEUE_H
+#define RENDERQUEUE_H
+
+#include <vector>
+#include <functional>
+#include <cstdint>
+#include <GL/glew.h>
+#include "Shader.h"
+
+// Passes run in this order; each may have begin/end hooks
+enum RenderPass
+{
+    RENDER_PASS_SHADOW = 0,
+    RENDER_PASS_OPAQUE,
+    RENDER_PASS_BLENDED, // additive, depth-tested but not written (point sprites)
+    RENDER_PASS_OVERLAY,
+    RENDER_PASS_COUNT
+};
+
+struct DrawPacket
+{
+    unsigned pass = RENDER_PASS_OPAQUE;
+    const Shader *shader = nullptr;      // used before the draw when set
+    GLenum textureTarget = GL_TEXTURE_2D;
+    GLuint texture = 0;                  // bound on unit 0 when non-zero
+    GLuint mesh = 0;                     // VAO; only groups packets
+    float depth = 0.0f;                  // view distance over the far plane, 0..1
+    std::function<void()> draw;
+};
+
+// Draw packets collected over a frame, then radix-sorted on a 64-bit key and
+// executed. Key layout, most significant first:
+//   pass:4 | program:8 | texture:12 | mesh:12 | depth:24 | unused:4
+// so state changes are minimal within a pass and equal-state packets go front to back.
+class RenderQueue
+{
+public:
+    void clear();
+    void submit(const DrawPacket &packet);
+
+    // Hooks run around each pass (also when it has no packets), e.g. target setup
+    void setPassHooks(unsigned pass, std::function<void()> begin, std::function<void()> end = nullptr);
+
+    // Sort, then run every pass in order
+    void execute();
+    // Or sort once and run passes individually (e.g. from a RenderGraph)
+    void prepare();
+    void executePass(unsigned pass);
+
+    static uint64_t makeKey(const DrawPacket &packet);
+
+    int packetCount() const { return (int)m_packets.size(); }
+    int programSwitches() const { return m_programSwitches; }
+    int textureSwitches() const { return m_textureSwitches; }
+
+private:
+    std::vector<DrawPacket> m_packets;
+    std::vector<uint64_t> m_keys;
+    std::vector<uint32_t> m_order, m_scratch;
+    std::function<void()> m_begin[RENDER_PASS_COUNT], m_end[RENDER_PASS_COUNT];
+    size_t m_passFirst[RENDER_PASS_COUNT + 1] = {};
+    const Shader *m_program = nullptr;
+    GLuint m_texture = 0;
+    int m_programSwitches = 0, m_textureSwitches = 0;
+
+    void sort();
+};
+
+#endif
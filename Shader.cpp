@@ -1,65 +1,215 @@
 #include "Shader.h"
+#include "GLState.h"
 #include <iostream>
 #include <fstream>
 #include <sstream>
+#include <vector>
+#include <iterator>
+#include <cstdio>
+#include <cstring>
+#include <cstdint>
+#ifdef _WIN32
+#include <direct.h>
+#else
+#include <sys/stat.h>
+#endif
 
-Shader::Shader(const char *vertexPath, const char *fragmentPath)
-{
-    std::string vertexCode, fragmentCode;
-    std::ifstream vShaderFile, fShaderFile;
+// Linked program binaries, relative to the working directory (like assets/)
+static const char *SHADER_CACHE_DIR = "shader_cache";
 
-    vShaderFile.exceptions(std::ifstream::failbit | std::ifstream::badbit);
-    fShaderFile.exceptions(std::ifstream::failbit | std::ifstream::badbit);
+std::string Shader::readFile(const char *path)
+{
+    std::ifstream file;
+    file.exceptions(std::ifstream::failbit | std::ifstream::badbit);
     try
     {
-        vShaderFile.open(vertexPath);
-        fShaderFile.open(fragmentPath);
-        std::stringstream vStream, fStream;
-        vStream << vShaderFile.rdbuf();
-        fStream << fShaderFile.rdbuf();
-        vShaderFile.close();
-        fShaderFile.close();
-        vertexCode = vStream.str();
-        fragmentCode = fStream.str();
+        file.open(path);
+        std::stringstream stream;
+        stream << file.rdbuf();
+        file.close();
+        return stream.str();
     }
     catch (std::ifstream::failure &e)
     {
-        std::cerr << "ERROR: SHADER FILE NOT READ SUCCESSFULLY\n";
+        std::cerr << "ERROR: SHADER FILE NOT READ SUCCESSFULLY: " << path << "\n";
     }
+    return std::string();
+}
 
-    const char *vShaderCode = vertexCode.c_str();
-    const char *fShaderCode = fragmentCode.c_str();
+std::string Shader::injectDefines(const std::string &source, const std::string &defines)
+{
+    if (defines.empty())
+        return source;
+    // #version has to stay the first line, and #extension has to come before
+    // any declaration
+    size_t insertAt = 0;
+    for (;;)
+    {
+        size_t lineEnd = source.find('\n', insertAt);
+        if (lineEnd == std::string::npos ||
+            (source.compare(insertAt, 8, "#version") != 0 && source.compare(insertAt, 10, "#extension") != 0))
+            break;
+        insertAt = lineEnd + 1;
+    }
+    return source.substr(0, insertAt) + defines + source.substr(insertAt);
+}
 
-    GLuint vertex, fragment;
-    int success;
-    char infoLog[512];
+// FNV-1a, 64-bit
+static uint64_t hashBytes(uint64_t hash, const void *data, size_t size)
+{
+    const unsigned char *bytes = (const unsigned char *)data;
+    for (size_t i = 0; i < size; ++i)
+    {
+        hash ^= bytes[i];
+        hash *= 1099511628211ull;
+    }
+    return hash;
+}
 
-    vertex = glCreateShader(GL_VERTEX_SHADER);
-    glShaderSource(vertex, 1, &vShaderCode, NULL);
-    glCompileShader(vertex);
-    glGetShaderiv(vertex, GL_COMPILE_STATUS, &success);
-    if (!success)
+static uint64_t hashString(uint64_t hash, const char *text)
+{
+    return text ? hashBytes(hash, text, std::strlen(text) + 1) : hash;
+}
+
+std::string Shader::binaryCachePath(const Stage *stages, int count)
+{
+    if (!(GLEW_VERSION_4_1 || GLEW_ARB_get_program_binary))
+        return std::string();
+    GLint formats = 0;
+    glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats);
+    if (formats <= 0)
+        return std::string();
+
+    // Binaries are only valid for the driver that produced them
+    uint64_t hash = 14695981039346656037ull;
+    hash = hashString(hash, (const char *)glGetString(GL_VENDOR));
+    hash = hashString(hash, (const char *)glGetString(GL_RENDERER));
+    hash = hashString(hash, (const char *)glGetString(GL_VERSION));
+    for (int i = 0; i < count; ++i)
     {
-        glGetShaderInfoLog(vertex, 512, NULL, infoLog);
-        std::cerr << "ERROR::VERTEX::COMPILATION_FAILED\n"
-                  << infoLog << std::endl;
+        hash = hashBytes(hash, &stages[i].type, sizeof(stages[i].type));
+        hash = hashString(hash, stages[i].source.c_str());
     }
 
-    fragment = glCreateShader(GL_FRAGMENT_SHADER);
-    glShaderSource(fragment, 1, &fShaderCode, NULL);
-    glCompileShader(fragment);
-    glGetShaderiv(fragment, GL_COMPILE_STATUS, &success);
+    char name[32];
+    std::snprintf(name, sizeof(name), "%016llx.bin", (unsigned long long)hash);
+    return std::string(SHADER_CACHE_DIR) + "/" + name;
+}
+
+bool Shader::loadBinary(const std::string &path)
+{
+    std::ifstream in(path, std::ios::binary);
+    if (!in.is_open())
+        return false;
+    std::vector<char> data((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+    if (data.size() <= sizeof(GLenum))
+        return false;
+
+    GLenum format;
+    std::memcpy(&format, data.data(), sizeof(format));
+    glProgramBinary(ID, format, data.data() + sizeof(format), (GLsizei)(data.size() - sizeof(format)));
+
+    // Drivers reject binaries after updates; the caller rebuilds from source
+    int success;
+    glGetProgramiv(ID, GL_LINK_STATUS, &success);
     if (!success)
+        std::cerr << "[Shader] Cached binary rejected, recompiling: " << path << "\n";
+    return success != 0;
+}
+
+void Shader::saveBinary(const std::string &path) const
+{
+    GLint length = 0;
+    glGetProgramiv(ID, GL_PROGRAM_BINARY_LENGTH, &length);
+    if (length <= 0)
+        return;
+    std::vector<char> data(sizeof(GLenum) + length);
+    GLenum format = 0;
+    glGetProgramBinary(ID, length, NULL, &format, data.data() + sizeof(GLenum));
+    std::memcpy(data.data(), &format, sizeof(format));
+
+#ifdef _WIN32
+    _mkdir(SHADER_CACHE_DIR);
+#else
+    mkdir(SHADER_CACHE_DIR, 0755);
+#endif
+    std::ofstream out(path, std::ios::binary);
+    if (out.is_open())
+        out.write(data.data(), (std::streamsize)data.size());
+}
+
+void Shader::submit(const Stage *stages, int count)
+{
+    m_cachePath = binaryCachePath(stages, count);
+
+    ID = glCreateProgram();
+    if (!m_cachePath.empty())
     {
-        glGetShaderInfoLog(fragment, 512, NULL, infoLog);
-        std::cerr << "ERROR::FRAGMENT::COMPILATION_FAILED\n"
-                  << infoLog << std::endl;
+        // Binaries skip the compiler, so checking this one right away costs little
+        if (loadBinary(m_cachePath))
+        {
+            m_cachePath.clear();
+            return;
+        }
+        // A rejected binary may leave the program unusable; start clean
+        glDeleteProgram(ID);
+        ID = glCreateProgram();
+        glProgramParameteri(ID, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
     }
 
-    ID = glCreateProgram();
-    glAttachShader(ID, vertex);
-    glAttachShader(ID, fragment);
+    // No status queries here: each one would wait for the compiler
+    for (int i = 0; i < count; ++i)
+    {
+        const char *source = stages[i].source.c_str();
+        GLuint shader = glCreateShader(stages[i].type);
+        glShaderSource(shader, 1, &source, NULL);
+        glCompileShader(shader);
+        glAttachShader(ID, shader);
+        m_pending.push_back(PendingStage{shader, stages[i].label});
+    }
     glLinkProgram(ID);
+}
+
+Shader::Shader(const char *vertexPath, const char *fragmentPath, const std::string &defines)
+{
+    Stage stages[2] = {{GL_VERTEX_SHADER, injectDefines(readFile(vertexPath), defines), "VERTEX"},
+                       {GL_FRAGMENT_SHADER, injectDefines(readFile(fragmentPath), defines), "FRAGMENT"}};
+    submit(stages, 2);
+}
+
+Shader::Shader(const char *computePath)
+{
+    Stage stage = {GL_COMPUTE_SHADER, readFile(computePath), "COMPUTE"};
+    submit(&stage, 1);
+}
+
+void Shader::enableParallelCompile()
+{
+    // 0xFFFFFFFF lets the driver pick the thread count
+    if (GLEW_KHR_parallel_shader_compile)
+        glMaxShaderCompilerThreadsKHR(0xFFFFFFFF);
+    else if (GLEW_ARB_parallel_shader_compile)
+        glMaxShaderCompilerThreadsARB(0xFFFFFFFF);
+}
+
+void Shader::finalize()
+{
+    if (m_finalized)
+        return;
+    m_finalized = true;
+
+    int success;
+    char infoLog[512];
+    for (const PendingStage &stage : m_pending)
+    {
+        glGetShaderiv(stage.shader, GL_COMPILE_STATUS, &success);
+        if (!success)
+        {
+            glGetShaderInfoLog(stage.shader, 512, NULL, infoLog);
+            std::cerr << "ERROR::" << stage.label << "::COMPILATION_FAILED\n"
+                      << infoLog << std::endl;
+        }
+    }
 
     glGetProgramiv(ID, GL_LINK_STATUS, &success);
     if (!success)
@@ -68,36 +218,76 @@ Shader::Shader(const char *vertexPath, const char *fragmentPath)
         std::cerr << "ERROR::SHADER::PROGRAM::LINKING_FAILED\n"
                   << infoLog << std::endl;
     }
+    else if (!m_cachePath.empty())
+    {
+        saveBinary(m_cachePath);
+    }
 
-    glDeleteShader(vertex);
-    glDeleteShader(fragment);
+    for (const PendingStage &stage : m_pending)
+        glDeleteShader(stage.shader);
+    m_pending.clear();
+
+    cacheUniforms();
 }
-void Shader::use() const
+
+void Shader::cacheUniforms()
 {
+    GLint count = 0, maxLength = 0;
+    glGetProgramiv(ID, GL_ACTIVE_UNIFORMS, &count);
+    glGetProgramiv(ID, GL_ACTIVE_UNIFORM_MAX_LENGTH, &maxLength);
+
+    std::vector<char> name(maxLength > 0 ? maxLength : 1);
+    for (GLint i = 0; i < count; ++i)
+    {
+        GLsizei length = 0;
+        GLint size = 0;
+        GLenum type = 0;
+        glGetActiveUniform(ID, (GLuint)i, (GLsizei)name.size(), &length, &size, &type, name.data());
+
+        // Members of uniform blocks have no location
+        std::string uniformName(name.data(), length);
+        GLint location = glGetUniformLocation(ID, uniformName.c_str());
+        if (location < 0)
+            continue;
+        m_uniforms[uniformName] = location;
+
+        // Arrays are reported as "name[0]"; also accept the bare name
+        size_t bracket = uniformName.find('[');
+        if (bracket != std::string::npos)
+            m_uniforms[uniformName.substr(0, bracket)] = location;
+    }
+}
 
-    glUseProgram(ID);
+GLint Shader::uniformLocation(const std::string &name) const
+{
+    auto it = m_uniforms.find(name);
+    return it != m_uniforms.end() ? it->second : -1;
+}
+void Shader::use() const
+{
+    GLState::useProgram(ID);
 }
 
 void Shader::setBool(const std::string &name, bool value) const
 {
-    glUniform1i(glGetUniformLocation(ID, name.c_str()), (int)value);
+    glUniform1i(uniformLocation(name), (int)value);
 }
 
 void Shader::setInt(const std::string &name, int value) const
 {
-    glUniform1i(glGetUniformLocation(ID, name.c_str()), value);
+    glUniform1i(uniformLocation(name), value);
 }
 
 void Shader::setFloat(const std::string &name, float value) const
 {
-    glUniform1f(glGetUniformLocation(ID, name.c_str()), value);
+    glUniform1f(uniformLocation(name), value);
 }
 
 void Shader::setMat4(const std::string &name, const glm::mat4 &mat) const
 {
-    glUniformMatrix4fv(glGetUniformLocation(ID, name.c_str()), 1, GL_FALSE, &mat[0][0]);
+    glUniformMatrix4fv(uniformLocation(name), 1, GL_FALSE, &mat[0][0]);
 }
 void Shader::setVec3(const std::string &name, const glm::vec3 &value) const
 {
-    glUniform3f(glGetUniformLocation(ID, name.c_str()), value.x, value.y, value.z);
+    glUniform3f(uniformLocation(name), value.x, value.y, value.z);
 }
\ No newline at end of file
@@ -2,27 +2,93 @@
 #define SHADER_H
 
 #include <string>
+#include <vector>
+#include <unordered_map>
 #include <glm/glm.hpp>
 #include <GL/glew.h>
 
+// Uniform location resolved once; T picks the matching glUniform* call.
+// A location of -1 (unknown or optimized out) is ignored by GL.
+template <typename T>
+struct Uniform
+{
+    GLint location = -1;
+};
+
 class Shader
 {
 public:
     // Program ID
     unsigned int ID;
 
-    // Constructor: build shader from file paths
-    Shader(const char *vertexPath, const char *fragmentPath);
+    // Constructors only submit the work: stages are compiled and the program
+    // linked without waiting for the results. Call finalize() before use().
+    // `defines` ("#define NAME\n" lines, then any shared declarations such as
+    // FrameUniforms::prelude()) go right after each stage's #version and #extension lines.
+    Shader(const char *vertexPath, const char *fragmentPath, const std::string &defines = std::string());
+    // Compute program from one file
+    explicit Shader(const char *computePath);
+
+    // Let the driver compile on its own threads (KHR/ARB_parallel_shader_compile);
+    // call once after glewInit, before creating programs
+    static void enableParallelCompile();
+
+    // Report compile/link errors, store the binary and build the uniform table.
+    // Blocks until the program is linked; does nothing the second time.
+    void finalize();
 
     // Activate the shader
     void use() const;
 
-    // Utility functions to set uniforms
+    // Location from the table built at link time, -1 if the program has no such uniform
+    GLint uniformLocation(const std::string &name) const;
+
+    // Typed handle for hot paths: resolve once, then set() with no lookup
+    template <typename T>
+    Uniform<T> uniform(const std::string &name) const { return Uniform<T>{uniformLocation(name)}; }
+
+    // Set through a handle; the program must be in use
+    void set(Uniform<bool> u, bool value) const { glUniform1i(u.location, (int)value); }
+    void set(Uniform<int> u, int value) const { glUniform1i(u.location, value); }
+    void set(Uniform<float> u, float value) const { glUniform1f(u.location, value); }
+    void set(Uniform<glm::vec3> u, const glm::vec3 &value) const { glUniform3f(u.location, value.x, value.y, value.z); }
+    void set(Uniform<glm::mat3> u, const glm::mat3 &mat) const { glUniformMatrix3fv(u.location, 1, GL_FALSE, &mat[0][0]); }
+    void set(Uniform<glm::mat4> u, const glm::mat4 &mat) const { glUniformMatrix4fv(u.location, 1, GL_FALSE, &mat[0][0]); }
+
+    // Utility functions to set uniforms by name (cached lookup, for setup code)
     void setBool(const std::string &name, bool value) const;
     void setInt(const std::string &name, int value) const;
     void setFloat(const std::string &name, float value) const;
     void setMat4(const std::string &name, const glm::mat4 &mat) const;
     void setVec3(const std::string &name, const glm::vec3 &value) const;
+
+private:
+    std::unordered_map<std::string, GLint> m_uniforms;
+
+    struct PendingStage
+    {
+        GLuint shader;
+        const char *label;
+    };
+    std::vector<PendingStage> m_pending; // compiled stages not checked yet
+    std::string m_cachePath;             // where finalize() stores the binary, empty if not caching
+    bool m_finalized = false;
+
+    struct Stage
+    {
+        GLenum type;
+        std::string source;
+        const char *label;
+    };
+
+    static std::string readFile(const char *path);
+    static std::string injectDefines(const std::string &source, const std::string &defines);
+    // Load the program from the binary cache, or start compiling and linking it
+    void submit(const Stage *stages, int count);
+    static std::string binaryCachePath(const Stage *stages, int count);
+    bool loadBinary(const std::string &path);
+    void saveBinary(const std::string &path) const;
+    void cacheUniforms();
 };
 
 #endif
@@ -0,0 +1,39 @@
+#include "ShaderPermutations.h"
+
+ShaderPermutations::ShaderPermutations(const char *vertexPath, const char *fragmentPath,
+                                       std::function<void(Shader &)> setup, const std::string &prelude)
+    : m_vertexPath(vertexPath), m_fragmentPath(fragmentPath), m_prelude(prelude), m_setup(std::move(setup))
+{
+}
+
+std::string ShaderPermutations::defines(unsigned int features)
+{
+    static const char *const NAMES[] = {"SHADOWS", "ATMOSPHERE", "EMISSIVE", "INSTANCED", "IMPOSTOR"};
+
+    std::string text;
+    for (int bit = 0; bit < (int)(sizeof(NAMES) / sizeof(NAMES[0])); ++bit)
+        if (features & (1u << bit))
+            text += std::string("#define ") + NAMES[bit] + "\n";
+    return text;
+}
+
+void ShaderPermutations::prepare(unsigned int features)
+{
+    Variant &variant = m_variants[features];
+    if (!variant.shader)
+        variant.shader.reset(new Shader(m_vertexPath.c_str(), m_fragmentPath.c_str(), defines(features) + m_prelude));
+}
+
+Shader &ShaderPermutations::get(unsigned int features)
+{
+    prepare(features);
+    Variant &variant = m_variants[features];
+    if (!variant.ready)
+    {
+        variant.shader->finalize();
+        if (m_setup)
+            m_setup(*variant.shader);
+        variant.ready = true;
+    }
+    return *variant.shader;
+}
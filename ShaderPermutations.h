@@ -0,0 +1,51 @@
+#ifndef SHADERPERMUTATIONS_H
+#define SHADERPERMUTATIONS_H
+
+#include <map>
+#include <memory>
+#include <string>
+#include <functional>
+#include "Shader.h"
+
+// Features a permutation is built with; each becomes a #define of the same name
+enum ShaderFeature
+{
+    SHADER_SHADOWS = 1 << 0,    // shadow map lookup
+    SHADER_ATMOSPHERE = 1 << 1, // Fresnel rim glow
+    SHADER_EMISSIVE = 1 << 2,   // unlit base color, no normals
+    SHADER_INSTANCED = 1 << 3,  // model and params per instance (spheres, terrain)
+    SHADER_IMPOSTOR = 1 << 4    // with INSTANCED: ray-cast sphere on a screen-aligned quad
+};
+
+// One vertex/fragment pair built into a program per feature set, on demand;
+// `prelude` follows the feature defines in every variant.
+// prepare() submits a variant so it compiles in the background (see Shader);
+// get() finalizes it on first use, runs `setup` on it once (block bindings,
+// sampler units) and caches it.
+class ShaderPermutations
+{
+public:
+    ShaderPermutations(const char *vertexPath, const char *fragmentPath,
+                       std::function<void(Shader &)> setup = nullptr, const std::string &prelude = std::string());
+
+    void prepare(unsigned int features);
+    Shader &get(unsigned int features);
+
+    int count() const { return (int)m_variants.size(); }
+
+    // "#define NAME\n" for every feature bit set
+    static std::string defines(unsigned int features);
+
+private:
+    struct Variant
+    {
+        std::unique_ptr<Shader> shader;
+        bool ready = false;
+    };
+
+    std::string m_vertexPath, m_fragmentPath, m_prelude;
+    std::function<void(Shader &)> m_setup;
+    std::map<unsigned int, Variant> m_variants;
+};
+
+#endif
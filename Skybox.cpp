@@ -4,6 +4,7 @@
 #include <iostream>
 
 Skybox::Skybox(const std::string &texturePath)
+    : m_texturePath(texturePath)
 {
     try
     {
@@ -25,19 +26,16 @@ Skybox::~Skybox()
     }
 }
 
-void Skybox::render(Shader &shader, unsigned int sphereVAO, int vertexCount, const glm::vec3 &cameraPosition)
+void Skybox::registerTexture(TextureArray &textures)
+{
+    m_textureLayer = textures.addLayer(m_texturePath, m_texture);
+}
+
+void Skybox::appendInstance(SphereBatch &batch, const glm::vec3 &cameraPosition) const
 {
     if (!m_texture)
         return;
 
-    // Disable depth writing so skybox is always drawn behind everything
-    glDepthMask(GL_FALSE);
-
-    // Bind skybox texture
-    glActiveTexture(GL_TEXTURE0);
-    m_texture->bind();
-    shader.setInt("texture1", 0);
-
     // Create a huge sphere centered on the camera
     glm::mat4 model = glm::mat4(1.0f);
     model = glm::translate(model, cameraPosition); // Follow the camera
@@ -46,15 +44,6 @@ void Skybox::render(Shader &shader, unsigned int sphereVAO, int vertexCount, con
     // Flip the sphere inside-out so we see the texture from the inside
     model = glm::scale(model, glm::vec3(-1.0f, 1.0f, 1.0f));
 
-    shader.setMat4("model", model);
-
-    // Set ambient lighting to full brightness for stars
-    shader.setVec3("lightPos", glm::vec3(0.0f)); // No directional lighting
-
-    // Render the skybox sphere
-    glBindVertexArray(sphereVAO);
-    glDrawArrays(GL_TRIANGLES, 0, vertexCount);
-
-    // Re-enable depth writing
-    glDepthMask(GL_TRUE);
-}
\ No newline at end of file
+    // Drawn last in the batch; the shader pins it to the far plane
+    batch.add(model, NormalMatrix::fromModel(model), m_textureLayer, SPHERE_SKY, SKY_LOD_LEVEL);
+}
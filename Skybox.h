@@ -2,19 +2,27 @@
 #define SKYBOX_H
 
 #include "Texture.h"
-#include "Shader.h"
+#include "SphereBatch.h"
+#include "TextureArray.h"
 #include <GL/glew.h>
 
+// Fixed mesh level for the star sphere: it always fills the screen, but a
+// textured backdrop has no silhouette to refine
+const int SKY_LOD_LEVEL = 3;
+
 class Skybox
 {
 public:
     Skybox(const std::string &texturePath);
     ~Skybox();
 
-    void render(Shader &shader, unsigned int sphereVAO, int vertexCount, const glm::vec3 &cameraPosition);
+    void registerTexture(TextureArray &textures);
+    void appendInstance(SphereBatch &batch, const glm::vec3 &cameraPosition) const;
 
 private:
     Texture *m_texture;
+    std::string m_texturePath;
+    int m_textureLayer = 0;
 };
 
 #endif
\ No newline at end of file
@@ -2,6 +2,7 @@
 #include <iostream>
 #include <algorithm>
 #include <limits>
+#include <cmath>
 
 SolarSystem::SolarSystem() {}
 SolarSystem::~SolarSystem() {}
@@ -14,6 +15,8 @@ void SolarSystem::initialize()
 
     createPlanets();
     createMoons();
+    collectBodies();
+    refitSpatialIndex();
 
     if (!m_planets.empty())
     {
@@ -21,6 +24,7 @@ void SolarSystem::initialize()
         m_planets[m_selected]->chooseRandomFact();
     }
     applySelectionFlags();
+    computeTransforms();
 
     std::cout << "Solar System initialized with " << m_planets.size() << " planets" << std::endl;
 }
@@ -33,17 +37,49 @@ void SolarSystem::update(float deltaTime)
         m_sun->update(dt);
     for (auto &planet : m_planets)
         planet->update(dt);
+
+    refitSpatialIndex();
+    computeTransforms();
 }
 
-void SolarSystem::render(Shader &shader, unsigned int sphereVAO, int vertexCount, const glm::vec3 &cameraPos)
+void SolarSystem::registerTextures(TextureArray &textures)
 {
-    shader.setVec3("viewPos", cameraPos);
+    for (CelestialBody *body : m_bodies)
+        body->setTextureLayer(textures.addLayer(body->getTexturePath(), body->getTexture()));
+}
 
-    if (m_sun)
-        m_sun->render(shader, sphereVAO, vertexCount);
+void SolarSystem::appendInstances(SphereBatch &batch, SpriteBatch &sprites, const glm::vec3 &eye, float pixelScale,
+                                  const CelestialBody *skip)
+{
+    for (int i = 0; i < (int)m_bodies.size(); ++i)
+    {
+        CelestialBody *body = m_bodies[i];
+        if (body == skip)
+            continue;
 
-    for (auto &planet : m_planets)
-        planet->render(shader, sphereVAO, vertexCount);
+        // Projected radius in pixels; inside or touching the sphere means full detail
+        float dist = glm::length(body->getPosition() - eye);
+        float radiusPx = (dist > body->getRadius()) ? body->getRadius() / dist * pixelScale : 1e6f;
+        body->setLodLevel(SphereMesh::selectLevel(radiusPx, body->getLodLevel()));
+        body->setSprite(SpriteBatch::selectSprite(radiusPx, body->isSprite()));
+
+        unsigned int flags = body->sphereFlags();
+        if (body->isSprite())
+        {
+            sprites.add(m_transforms.position(i), m_transforms.scale(i), body->getTextureLayer(), flags);
+            flags |= SPHERE_SHADOW_ONLY;
+        }
+        batch.add(m_transforms.model(i), m_transforms.normal(i), body->getTextureLayer(), flags, body->getLodLevel());
+    }
+}
+
+void SolarSystem::collectOccluders(SphereOccluders &occluders, const glm::vec3 &eye) const
+{
+    occluders.begin(eye);
+    if (m_sun)
+        occluders.add(m_sun->getPosition(), m_sun->getRadius());
+    for (const auto &planet : m_planets)
+        occluders.add(planet->getPosition(), planet->getRadius());
 }
 
 glm::vec3 SolarSystem::getSunPosition() const
@@ -180,14 +216,45 @@ std::string SolarSystem::selectedFact() const
     return m_planets[m_selected]->currentFact();
 }
 
+// Ray–sphere intersection; nearest hit in front of the origin
+static bool intersectRaySphere(const glm::vec3 &rayOrigin, const glm::vec3 &rayDir,
+                               const glm::vec3 &center, float radius, float &tOut)
+{
+    glm::vec3 oc = rayOrigin - center;
+    float a = glm::dot(rayDir, rayDir); // should be 1 if dir normalized
+    float b = 2.0f * glm::dot(oc, rayDir);
+    float c = glm::dot(oc, oc) - (radius * radius);
+
+    float discriminant = b * b - 4 * a * c;
+    if (discriminant < 0.0f)
+        return false;
+
+    float sqrtD = sqrtf(discriminant);
+    float t1 = (-b - sqrtD) / (2.0f * a);
+    float t2 = (-b + sqrtD) / (2.0f * a);
+
+    float t = std::numeric_limits<float>::infinity();
+    if (t1 > 0.0f)
+        t = t1;
+    if (t2 > 0.0f && t2 < t)
+        t = t2;
+
+    if (std::isinf(t))
+        return false;
+    tOut = t;
+    return true;
+}
+
 int SolarSystem::pickPlanet(const glm::vec3 &rayOrigin, const glm::vec3 &rayDir, float &tHit) const
 {
     int bestIdx = -1;
     float bestT = std::numeric_limits<float>::infinity();
     for (int i = 0; i < (int)m_planets.size(); ++i)
     {
+        // Same center and (highlighted) scale the sphere was drawn with
+        int body = m_planetBodies[i];
         float t;
-        if (m_planets[i]->intersectsRay(rayOrigin, rayDir, t))
+        if (intersectRaySphere(rayOrigin, rayDir, m_transforms.position(body), m_transforms.scale(body), t))
         {
             if (t > 0.0f && t < bestT)
             {
@@ -228,3 +295,46 @@ float SolarSystem::planetRadiusByIndex(int idx) const
         return 1.0f;
     return m_planets[idx]->getRadius();
 }
+
+void SolarSystem::collectBodies()
+{
+    m_bodies.clear();
+    if (m_sun)
+        m_bodies.push_back(m_sun.get());
+    m_planetBodies.clear();
+    for (auto &planet : m_planets)
+    {
+        m_planetBodies.push_back((int)m_bodies.size());
+        m_bodies.push_back(planet.get());
+        for (auto &moon : planet->getMoons())
+            m_bodies.push_back(moon.get());
+    }
+}
+
+void SolarSystem::refitSpatialIndex()
+{
+    // Bodies only drift a little per frame, so most updates stay in their cell
+    for (int i = 0; i < (int)m_bodies.size(); ++i)
+        m_spatial.update(i, m_bodies[i]->getPosition(), m_bodies[i]->getRadius());
+}
+
+void SolarSystem::computeTransforms()
+{
+    // One batch for the frame: both passes and picking read it
+    m_transforms.resize((int)m_bodies.size());
+    for (int i = 0; i < (int)m_bodies.size(); ++i)
+    {
+        const CelestialBody *body = m_bodies[i];
+        m_transforms.set(i, body->getPosition(), body->getRotationY(), body->getScale());
+    }
+    m_transforms.compute();
+}
+
+float SolarSystem::nearestSurfaceDistance(const glm::vec3 &p, int *bodyIdx) const
+{
+    float dist;
+    int idx = m_spatial.nearest(p, dist);
+    if (bodyIdx)
+        *bodyIdx = idx;
+    return dist;
+}
@@ -9,6 +9,12 @@
 #include "Planet.h"
 #include "Moon.h"
 #include "Shader.h"
+#include "SpatialIndex.h"
+#include "SphereBatch.h"
+#include "SpriteBatch.h"
+#include "TextureArray.h"
+#include "SphereOccluders.h"
+#include "TransformBatch.h"
 
 class SolarSystem
 {
@@ -35,10 +41,19 @@ public:
     float selectedRadius() const;
     std::string selectedFact() const;
 
-    // Rendering
-    void render(Shader &shader, unsigned int sphereVAO, int vertexCount, const glm::vec3 &cameraPos);
+    // Rendering: every body becomes one instance of the shared sphere batch
+    void registerTextures(TextureArray &textures);
+    // Mesh LOD follows each body's projected size; pixelScale is Camera::getPixelScale().
+    // Sub-pixel bodies go to `sprites` and keep only a coarse shadow-casting mesh.
+    // `skip` is left out (drawn by PlanetTerrain instead).
+    void appendInstances(SphereBatch &batch, SpriteBatch &sprites, const glm::vec3 &eye, float pixelScale,
+                         const CelestialBody *skip = nullptr);
 
-    // Picking (ray from origin along dir). Returns index or -1. tHit is distance along the ray.
+    // The Sun and planets, at their true radius, as occluders seen from `eye`
+    void collectOccluders(SphereOccluders &occluders, const glm::vec3 &eye) const;
+
+    // Picking (ray from origin along dir) against the spheres as drawn this frame.
+    // Returns index or -1. tHit is distance along the ray.
     int pickPlanet(const glm::vec3 &rayOrigin, const glm::vec3 &rayDir, float &tHit) const;
 
     // For lighting, etc.
@@ -49,9 +64,22 @@ public:
     glm::vec3 planetPosition(int idx) const;
     float planetRadiusByIndex(int idx) const;
 
+    // Every body (sun, planets, moons) in a stable order; ids in the spatial index match.
+    const std::vector<CelestialBody *> &bodies() const { return m_bodies; }
+    // This frame's model and normal matrices, indexed like bodies()
+    const TransformBatch &transforms() const { return m_transforms; }
+
+    // Proximity queries against the per-frame spatial index
+    const SpatialIndex &spatialIndex() const { return m_spatial; }
+    float nearestSurfaceDistance(const glm::vec3 &p, int *bodyIdx = nullptr) const;
+
 private:
     std::unique_ptr<Sun> m_sun;
     std::vector<std::shared_ptr<Planet>> m_planets;
+    std::vector<CelestialBody *> m_bodies;
+    std::vector<int> m_planetBodies; // index in m_bodies of each planet
+    SpatialIndex m_spatial;
+    TransformBatch m_transforms;
 
     // Interactive state
     bool m_paused = false;
@@ -61,6 +89,9 @@ private:
     void createPlanets();
     void createMoons();
     void applySelectionFlags();
+    void collectBodies();
+    void refitSpatialIndex();
+    void computeTransforms();
 };
 
 #endif
@@ -0,0 +1,194 @@
+#include "SpatialIndex.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <limits>
+
+SpatialIndex::SpatialIndex(float cellSize)
+    : m_cellSize(cellSize > 0.0f ? cellSize : 1.0f)
+{
+}
+
+void SpatialIndex::clear()
+{
+    m_entries.clear();
+    m_cells.clear();
+    m_count = 0;
+    m_maxRadius = 0.0f;
+    m_min = {0, 0, 0};
+    m_max = {-1, -1, -1};
+}
+
+SpatialIndex::CellCoord SpatialIndex::cellOf(const glm::vec3 &p) const
+{
+    return {(int)std::floor(p.x / m_cellSize),
+            (int)std::floor(p.y / m_cellSize),
+            (int)std::floor(p.z / m_cellSize)};
+}
+
+int64_t SpatialIndex::packCell(const CellCoord &c)
+{
+    // 21 bits per axis, offset so negative coordinates pack cleanly
+    const int64_t bias = 1 << 20, mask = (1 << 21) - 1;
+    return (((int64_t)c.x + bias) & mask) |
+           ((((int64_t)c.y + bias) & mask) << 21) |
+           ((((int64_t)c.z + bias) & mask) << 42);
+}
+
+void SpatialIndex::update(int id, const glm::vec3 &center, float radius)
+{
+    if (id < 0)
+        return;
+    if (id >= (int)m_entries.size())
+        m_entries.resize(id + 1);
+
+    CellCoord c = cellOf(center);
+    int64_t key = packCell(c);
+    Entry &e = m_entries[id];
+
+    if (e.live && e.cell != key)
+    {
+        std::vector<int> &old = m_cells[e.cell];
+        auto it = std::find(old.begin(), old.end(), id);
+        if (it != old.end())
+        {
+            *it = old.back();
+            old.pop_back();
+        }
+    }
+    if (!e.live || e.cell != key)
+        m_cells[key].push_back(id);
+    if (!e.live)
+        ++m_count;
+
+    e.center = center;
+    e.radius = radius;
+    e.cell = key;
+    e.live = true;
+    m_maxRadius = std::max(m_maxRadius, radius);
+
+    if (m_max.x < m_min.x)
+    {
+        m_min = c;
+        m_max = c;
+    }
+    else
+    {
+        m_min = {std::min(m_min.x, c.x), std::min(m_min.y, c.y), std::min(m_min.z, c.z)};
+        m_max = {std::max(m_max.x, c.x), std::max(m_max.y, c.y), std::max(m_max.z, c.z)};
+    }
+}
+
+void SpatialIndex::remove(int id)
+{
+    if (id < 0 || id >= (int)m_entries.size() || !m_entries[id].live)
+        return;
+    Entry &e = m_entries[id];
+    std::vector<int> &bucket = m_cells[e.cell];
+    auto it = std::find(bucket.begin(), bucket.end(), id);
+    if (it != bucket.end())
+    {
+        *it = bucket.back();
+        bucket.pop_back();
+    }
+    e.live = false;
+    --m_count;
+}
+
+void SpatialIndex::visitCell(int x, int y, int z, const glm::vec3 &p, int &bestId, float &bestDist) const
+{
+    auto it = m_cells.find(packCell({x, y, z}));
+    if (it == m_cells.end())
+        return;
+    for (int id : it->second)
+    {
+        const Entry &e = m_entries[id];
+        float d = glm::length(p - e.center) - e.radius;
+        if (d < bestDist)
+        {
+            bestDist = d;
+            bestId = id;
+        }
+    }
+}
+
+int SpatialIndex::nearest(const glm::vec3 &p, float &surfaceDist) const
+{
+    surfaceDist = std::numeric_limits<float>::infinity();
+    if (m_count == 0)
+        return -1;
+
+    CellCoord c = cellOf(p);
+
+    // Nothing lives outside the occupied range, so start at its edge and stop
+    // once the ring has swept all of it.
+    int k0 = std::max({0, m_min.x - c.x, c.x - m_max.x,
+                       m_min.y - c.y, c.y - m_max.y,
+                       m_min.z - c.z, c.z - m_max.z});
+    int kMax = std::max({std::abs(c.x - m_min.x), std::abs(c.x - m_max.x),
+                         std::abs(c.y - m_min.y), std::abs(c.y - m_max.y),
+                         std::abs(c.z - m_min.z), std::abs(c.z - m_max.z)});
+
+    int bestId = -1;
+    float best = std::numeric_limits<float>::infinity();
+    for (int k = k0; k <= kMax; ++k)
+    {
+        // Every sphere centered in ring k is at least (k - 1) cells from p
+        if (bestId >= 0 && best <= (float)(k - 1) * m_cellSize - m_maxRadius)
+            break;
+
+        int x0 = std::max(c.x - k, m_min.x), x1 = std::min(c.x + k, m_max.x);
+        int y0 = std::max(c.y - k, m_min.y), y1 = std::min(c.y + k, m_max.y);
+        int z0 = std::max(c.z - k, m_min.z), z1 = std::min(c.z + k, m_max.z);
+        for (int x = x0; x <= x1; ++x)
+        {
+            for (int y = y0; y <= y1; ++y)
+            {
+                if (std::abs(x - c.x) == k || std::abs(y - c.y) == k)
+                {
+                    for (int z = z0; z <= z1; ++z)
+                        visitCell(x, y, z, p, bestId, best);
+                    continue;
+                }
+                // Interior column: only the two shell faces along z
+                if (c.z - k >= m_min.z && c.z - k <= m_max.z)
+                    visitCell(x, y, c.z - k, p, bestId, best);
+                if (k > 0 && c.z + k >= m_min.z && c.z + k <= m_max.z)
+                    visitCell(x, y, c.z + k, p, bestId, best);
+            }
+        }
+    }
+
+    surfaceDist = best;
+    return bestId;
+}
+
+void SpatialIndex::queryRadius(const glm::vec3 &p, float radius, std::vector<int> &out) const
+{
+    out.clear();
+    if (m_count == 0)
+        return;
+
+    float reach = radius + m_maxRadius;
+    CellCoord lo = cellOf(p - glm::vec3(reach));
+    CellCoord hi = cellOf(p + glm::vec3(reach));
+    lo = {std::max(lo.x, m_min.x), std::max(lo.y, m_min.y), std::max(lo.z, m_min.z)};
+    hi = {std::min(hi.x, m_max.x), std::min(hi.y, m_max.y), std::min(hi.z, m_max.z)};
+
+    for (int x = lo.x; x <= hi.x; ++x)
+        for (int y = lo.y; y <= hi.y; ++y)
+            for (int z = lo.z; z <= hi.z; ++z)
+            {
+                auto it = m_cells.find(packCell({x, y, z}));
+                if (it == m_cells.end())
+                    continue;
+                for (int id : it->second)
+                {
+                    const Entry &e = m_entries[id];
+                    float r = radius + e.radius;
+                    glm::vec3 d = p - e.center;
+                    if (glm::dot(d, d) <= r * r)
+                        out.push_back(id);
+                }
+            }
+}
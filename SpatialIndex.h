@@ -0,0 +1,61 @@
+#ifndef SPATIALINDEX_H
+#define SPATIALINDEX_H
+
+#include <vector>
+#include <unordered_map>
+#include <cstdint>
+#include <glm/glm.hpp>
+
+// Loose uniform grid over bounding spheres. Each sphere is bucketed by its
+// center only; queries widen their search by the largest radius seen, so a
+// sphere never needs to live in more than one cell.
+class SpatialIndex
+{
+public:
+    explicit SpatialIndex(float cellSize = 4.0f);
+
+    void clear();
+
+    // Insert a new id or move an existing one. Only touches the buckets when
+    // the sphere actually crosses into a different cell.
+    void update(int id, const glm::vec3 &center, float radius);
+    void remove(int id);
+
+    // Closest sphere surface to p. Returns the id (or -1 when empty) and the
+    // distance to that surface in surfaceDist (negative when p is inside).
+    int nearest(const glm::vec3 &p, float &surfaceDist) const;
+
+    // All spheres overlapping the query sphere (p, radius).
+    void queryRadius(const glm::vec3 &p, float radius, std::vector<int> &out) const;
+
+    int size() const { return m_count; }
+
+private:
+    struct Entry
+    {
+        glm::vec3 center;
+        float radius = 0.0f;
+        int64_t cell = 0;
+        bool live = false;
+    };
+
+    struct CellCoord
+    {
+        int x, y, z;
+    };
+
+    float m_cellSize;
+    float m_maxRadius = 0.0f;
+    int m_count = 0;
+    std::vector<Entry> m_entries; // indexed by id
+    std::unordered_map<int64_t, std::vector<int>> m_cells;
+
+    // Occupied cell range (grows only until clear(), which keeps it conservative)
+    CellCoord m_min{0, 0, 0}, m_max{-1, -1, -1};
+
+    CellCoord cellOf(const glm::vec3 &p) const;
+    static int64_t packCell(const CellCoord &c);
+    void visitCell(int x, int y, int z, const glm::vec3 &p, int &bestId, float &bestDist) const;
+};
+
+#endif
@@ -0,0 +1,208 @@
+#include "SphereBatch.h"
+#include "GLState.h"
+#include <cstddef>
+#include <algorithm>
+#include <limits>
+
+SphereBatch::SphereBatch()
+    : m_stream(1024 * sizeof(SphereInstance))
+{
+}
+
+void SphereBatch::attach(const SphereMesh &mesh)
+{
+    m_mesh = &mesh;
+    glBindVertexArray(mesh.vao());
+    for (GLuint loc = 3; loc <= 10; ++loc)
+    {
+        glEnableVertexAttribArray(loc);
+        glVertexAttribDivisor(loc, 1);
+    }
+    glBindVertexArray(0);
+}
+
+void SphereBatch::pointInstanceAttributes(size_t firstInstance) const
+{
+    // Expects the sphere VAO and the instance stream to be bound
+    size_t base = m_streamOffset + firstInstance * sizeof(SphereInstance);
+
+    // mat4 model takes four consecutive vec4 slots
+    for (int col = 0; col < 4; ++col)
+        glVertexAttribPointer(3 + col, 4, GL_FLOAT, GL_FALSE, sizeof(SphereInstance),
+                              (void *)(base + offsetof(SphereInstance, model) + col * sizeof(glm::vec4)));
+    glVertexAttribPointer(7, 4, GL_FLOAT, GL_FALSE, sizeof(SphereInstance),
+                          (void *)(base + offsetof(SphereInstance, params)));
+    // mat3 normal matrix: three vec3 slots over the padded columns
+    for (int col = 0; col < 3; ++col)
+        glVertexAttribPointer(8 + col, 3, GL_FLOAT, GL_FALSE, sizeof(SphereInstance),
+                              (void *)(base + offsetof(SphereInstance, normal) + col * sizeof(glm::vec4)));
+}
+
+void SphereBatch::clear()
+{
+    m_instances.clear();
+    m_lods.clear();
+    m_bounds.clear();
+    m_culler.clear();
+    for (Pass &pass : m_passes)
+    {
+        for (auto &shading : pass.buckets)
+            for (auto &bucket : shading)
+                bucket.clear();
+        pass.visible = 0;
+        pass.occluded = 0;
+    }
+}
+
+void SphereBatch::add(const glm::mat4 &model, const NormalMatrix &normal, int layer, unsigned int flags, int lodLevel)
+{
+    m_instances.push_back(SphereInstance{model, glm::vec4((float)layer, (float)flags, 0.0f, 0.0f), normal});
+    m_lods.push_back(lodLevel);
+
+    // Unit sphere mesh: the bound is the largest axis scale around the translation
+    float radius = std::max(glm::length(glm::vec3(model[0])),
+                            std::max(glm::length(glm::vec3(model[1])), glm::length(glm::vec3(model[2]))));
+    m_bounds.push_back(glm::vec4(glm::vec3(model[3]), radius));
+    m_culler.add(glm::vec3(model[3]), radius);
+}
+
+void SphereBatch::cull(int passIndex, const Frustum &frustum, const SphereOccluders *occluders)
+{
+    Pass &pass = m_passes[passIndex];
+    for (int s = 0; s < SPHERE_SHADING_COUNT; ++s)
+    {
+        for (int l = 0; l < SphereMesh::LEVEL_COUNT; ++l)
+        {
+            pass.buckets[s][l].clear();
+            pass.nearest[s][l] = 0.0f;
+        }
+    }
+
+    m_culler.cull(frustum, m_visible);
+
+    pass.visible = 0;
+    pass.occluded = 0;
+    for (size_t i = 0; i < m_instances.size(); ++i)
+    {
+        bool keep = m_visible[i] != 0;
+        unsigned int flags = (unsigned int)m_instances[i].params.y;
+        bool sky = (flags & SPHERE_SKY) != 0;
+        if (sky)
+            keep = (passIndex == SPHERE_PASS_MAIN);
+        if ((flags & SPHERE_EMISSIVE) && passIndex == SPHERE_PASS_SHADOW)
+            keep = false; // the light source casts no shadow of its own
+        if ((flags & SPHERE_SHADOW_ONLY) && passIndex == SPHERE_PASS_MAIN)
+            keep = false;
+        if (!keep)
+            continue;
+        if (occluders && !sky && occluders->isOccluded(glm::vec3(m_bounds[i]), m_bounds[i].w))
+        {
+            ++pass.occluded;
+            continue;
+        }
+        int shading = (flags & (SPHERE_EMISSIVE | SPHERE_SKY)) ? SPHERE_SHADING_EMISSIVE : SPHERE_SHADING_LIT;
+        int level = (m_impostors && passIndex == SPHERE_PASS_MAIN) ? 0 : m_lods[i];
+        pass.buckets[shading][level].push_back(m_instances[i]);
+        ++pass.visible;
+    }
+}
+
+int SphereBatch::litCount(int passIndex) const
+{
+    int count = 0;
+    for (int l = 0; l < SphereMesh::LEVEL_COUNT; ++l)
+        count += (int)m_passes[passIndex].buckets[SPHERE_SHADING_LIT][l].size();
+    return count;
+}
+
+void SphereBatch::sortFrontToBack(int passIndex, const glm::vec3 &eye)
+{
+    // The sky sorts as infinitely far, so it is shaded last
+    auto distance = [&eye](const SphereInstance &inst)
+    {
+        if ((unsigned int)inst.params.y & SPHERE_SKY)
+            return std::numeric_limits<float>::max();
+        return glm::length(glm::vec3(inst.model[3]) - eye);
+    };
+
+    Pass &pass = m_passes[passIndex];
+    for (int s = 0; s < SPHERE_SHADING_COUNT; ++s)
+    {
+        for (int l = 0; l < SphereMesh::LEVEL_COUNT; ++l)
+        {
+            auto &bucket = pass.buckets[s][l];
+            std::sort(bucket.begin(), bucket.end(), [&](const SphereInstance &a, const SphereInstance &b)
+                      { return distance(a) < distance(b); });
+            pass.nearest[s][l] = bucket.empty() ? 0.0f : distance(bucket.front());
+        }
+    }
+}
+
+void SphereBatch::upload()
+{
+    // Passes back to back, each with its buckets laid out finest level last
+    m_staging.clear();
+    for (Pass &pass : m_passes)
+    {
+        pass.first = m_staging.size();
+        for (int s = 0; s < SPHERE_SHADING_COUNT; ++s)
+        {
+            for (int l = 0; l < SphereMesh::LEVEL_COUNT; ++l)
+            {
+                pass.bucketFirst[s][l] = m_staging.size();
+                m_staging.insert(m_staging.end(), pass.buckets[s][l].begin(), pass.buckets[s][l].end());
+            }
+        }
+    }
+
+    if (!m_staging.empty())
+        m_streamOffset = m_stream.write(m_staging.data(), m_staging.size() * sizeof(SphereInstance));
+}
+
+void SphereBatch::submit(RenderQueue &queue, int passIndex, const DrawPacket &proto, float farPlane,
+                         const Shader *emissiveShader) const
+{
+    const Pass &pass = m_passes[passIndex];
+    if (!m_mesh)
+        return;
+
+    for (int s = 0; s < SPHERE_SHADING_COUNT; ++s)
+    {
+        for (int l = 0; l < SphereMesh::LEVEL_COUNT; ++l)
+        {
+            if (pass.buckets[s][l].empty())
+                continue;
+
+            DrawPacket packet = proto;
+            if (s == SPHERE_SHADING_EMISSIVE && emissiveShader)
+                packet.shader = emissiveShader;
+            packet.mesh = m_mesh->vao();
+            packet.depth = pass.nearest[s][l] / farPlane;
+            packet.draw = [this, passIndex, s, l]() { drawBucket(passIndex, s, l); };
+            queue.submit(packet);
+        }
+    }
+}
+
+void SphereBatch::drawBucket(int passIndex, int shading, int level) const
+{
+    const Pass &pass = m_passes[passIndex];
+    size_t count = pass.buckets[shading][level].size();
+    if (!m_mesh || count == 0)
+        return;
+
+    GLState::bindVertexArray(m_mesh->vao());
+    glBindBuffer(GL_ARRAY_BUFFER, m_stream.id());
+    pointInstanceAttributes(pass.bucketFirst[shading][level]);
+
+    // The quad's corners come from gl_VertexID; the mesh attributes go unread
+    if (m_impostors && passIndex == SPHERE_PASS_MAIN)
+    {
+        glDrawArraysInstanced(GL_TRIANGLE_STRIP, 0, 4, (GLsizei)count);
+        return;
+    }
+
+    const SphereMesh::Level &lvl = m_mesh->level(level);
+    glDrawElementsInstancedBaseVertex(GL_TRIANGLES, lvl.indexCount, GL_UNSIGNED_SHORT,
+                                      (void *)lvl.firstIndexBytes, (GLsizei)count, lvl.baseVertex);
+}
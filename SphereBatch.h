@@ -0,0 +1,123 @@
+#ifndef SPHEREBATCH_H
+#define SPHEREBATCH_H
+
+#include <vector>
+#include <glm/glm.hpp>
+#include <GL/glew.h>
+#include "SphereMesh.h"
+#include "FrustumCuller.h"
+#include "SphereOccluders.h"
+#include "RenderQueue.h"
+#include "StreamBuffer.h"
+#include "TransformBatch.h"
+
+// Per-instance flags, read by the instanced sphere shaders
+enum SphereFlags
+{
+    SPHERE_EMISSIVE = 1 << 0, // unlit, full texture color (the Sun)
+    SPHERE_SKY = 1 << 1,      // pinned to the far plane, never casts shadows
+    SPHERE_UNTEXTURED = 1 << 2, // plain white base color (OBJ models on the indirect path)
+    SPHERE_SHADOW_ONLY = 1 << 3 // a point sprite in the main pass (see SpriteBatch); the mesh only casts
+};
+
+// Passes the batch is culled and drawn for
+enum SpherePass
+{
+    SPHERE_PASS_SHADOW = 0,
+    SPHERE_PASS_MAIN,
+    SPHERE_PASS_COUNT
+};
+
+// Shader permutation an instance needs; each goes out in its own draws
+enum SphereShading
+{
+    SPHERE_SHADING_LIT = 0,
+    SPHERE_SHADING_EMISSIVE, // SPHERE_EMISSIVE or SPHERE_SKY: base color only
+    SPHERE_SHADING_COUNT
+};
+
+struct SphereInstance
+{
+    glm::mat4 model;
+    glm::vec4 params; // x = texture array layer, y = SphereFlags
+    NormalMatrix normal;
+};
+
+// Collects every sphere drawn this frame into one instance buffer, bucketed
+// by shading and mesh LOD, so the whole set goes out in one instanced draw
+// per bucket.
+// Each pass gets its own frustum-culled copy of the instances. With impostors
+// on, the main pass draws each sphere as a 4-vertex quad instead (shaders
+// built with SHADER_IMPOSTOR) and LOD no longer splits its buckets.
+class SphereBatch
+{
+public:
+    SphereBatch();
+
+    // Add the instance attributes (locations 3-10) to the shared sphere VAO
+    void attach(const SphereMesh &mesh);
+
+    void setImpostors(bool enabled) { m_impostors = enabled; }
+    bool impostors() const { return m_impostors; }
+
+    void clear();
+    void add(const glm::mat4 &model, const NormalMatrix &normal, int layer, unsigned int flags, int lodLevel);
+
+    // Keep the instances whose bounding sphere touches `frustum` for `pass`,
+    // minus those hidden behind one of `occluders` (if given).
+    // The sky is always kept in the main pass; neither it nor emissive
+    // instances cast shadows.
+    // SPHERE_SHADOW_ONLY instances are never kept in the main pass.
+    void cull(int pass, const Frustum &frustum, const SphereOccluders *occluders = nullptr);
+
+    // Order each bucket of `pass` nearest first, the sky last, for early-z
+    void sortFrontToBack(int pass, const glm::vec3 &eye);
+
+    // Upload every culled pass back to back; sortFrontToBack must run first,
+    // since the GPU only sees the order the buckets have here
+    void upload();
+
+    // Queue one packet per non-empty bucket of `pass`. `proto` supplies the
+    // render pass, shader and texture; the mesh and depth fields are filled in.
+    // Emissive buckets use `emissiveShader` instead when one is given.
+    void submit(RenderQueue &queue, int pass, const DrawPacket &proto, float farPlane,
+                const Shader *emissiveShader = nullptr) const;
+    void drawBucket(int pass, int shading, int level) const;
+
+    int size() const { return (int)m_instances.size(); }
+    const SphereInstance &instance(int i) const { return m_instances[i]; }
+    int lod(int i) const { return m_lods[i]; }
+    const glm::vec4 &bounds(int i) const { return m_bounds[i]; }
+    int visibleCount(int pass) const { return m_passes[pass].visible; }
+    int culledCount(int pass) const { return size() - m_passes[pass].visible - m_passes[pass].occluded; }
+    int occludedCount(int pass) const { return m_passes[pass].occluded; }
+    // Kept instances of `pass` that are lit, i.e. sample the shadow map
+    int litCount(int pass) const;
+
+private:
+    const SphereMesh *m_mesh = nullptr;
+    bool m_impostors = false;
+    StreamBuffer m_stream;     // this frame's instances, every pass back to back
+    size_t m_streamOffset = 0; // where upload() put them
+    std::vector<SphereInstance> m_instances;
+    std::vector<int> m_lods;
+    std::vector<glm::vec4> m_bounds; // xyz center, w radius
+    FrustumCuller m_culler;
+    std::vector<unsigned char> m_visible;
+
+    struct Pass
+    {
+        std::vector<SphereInstance> buckets[SPHERE_SHADING_COUNT][SphereMesh::LEVEL_COUNT];
+        size_t first = 0; // offset of this pass in the instance buffer
+        size_t bucketFirst[SPHERE_SHADING_COUNT][SphereMesh::LEVEL_COUNT] = {};
+        float nearest[SPHERE_SHADING_COUNT][SphereMesh::LEVEL_COUNT] = {}; // eye distance of the closest instance
+        int visible = 0;
+        int occluded = 0;
+    };
+    Pass m_passes[SPHERE_PASS_COUNT];
+    std::vector<SphereInstance> m_staging;
+
+    void pointInstanceAttributes(size_t firstInstance) const;
+};
+
+#endif
@@ -0,0 +1,82 @@
+#include "SphereBenchmark.h"
+#include "StressField.h"
+#include <algorithm>
+#include <iomanip>
+
+const char *spherePathName(int path)
+{
+    static const char *const NAMES[SPHERE_PATH_COUNT] = {"meshes", "GPU-driven", "impostors"};
+    return (path >= 0 && path < SPHERE_PATH_COUNT) ? NAMES[path] : "?";
+}
+
+void SphereBenchmark::start(bool gpuDrivenSupported)
+{
+    m_steps.clear();
+    for (int stressStep = 1; stressStep < StressField::STEP_COUNT; ++stressStep)
+    {
+        for (int path = 0; path < SPHERE_PATH_COUNT; ++path)
+        {
+            if (path == SPHERE_PATH_GPU_DRIVEN && !gpuDrivenSupported)
+                continue;
+            Step step;
+            step.stressStep = stressStep;
+            step.path = path;
+            m_steps.push_back(step);
+        }
+    }
+    m_current = 0;
+    m_running = !m_steps.empty();
+    m_finished = false;
+}
+
+bool SphereBenchmark::justFinished()
+{
+    bool finished = m_finished;
+    m_finished = false;
+    return finished;
+}
+
+void SphereBenchmark::addFrame(float sceneMs)
+{
+    if (!m_running)
+        return;
+
+    Step &step = m_steps[m_current];
+    if (++step.frames > WARMUP_FRAMES && sceneMs >= 0.0f)
+    {
+        step.minMs = step.samples ? std::min(step.minMs, sceneMs) : sceneMs;
+        step.maxMs = step.samples ? std::max(step.maxMs, sceneMs) : sceneMs;
+        step.sumMs += sceneMs;
+        ++step.samples;
+    }
+    // Give up on a configuration whose timer never reports
+    if (step.samples < MEASURE_FRAMES && step.frames < WARMUP_FRAMES + 4 * MEASURE_FRAMES)
+        return;
+
+    if (++m_current == (int)m_steps.size())
+    {
+        m_current = (int)m_steps.size() - 1;
+        m_running = false;
+        m_finished = true;
+    }
+}
+
+void SphereBenchmark::printTable(std::ostream &out) const
+{
+    out << "Sphere path benchmark: scene pass GPU time over " << MEASURE_FRAMES << " frames after "
+        << WARMUP_FRAMES << " warm-up\n"
+        << std::setw(8) << "bodies" << std::setw(12) << "path" << std::setw(10) << "mean ms"
+        << std::setw(10) << "min ms" << std::setw(10) << "max ms" << "\n";
+    for (const Step &step : m_steps)
+    {
+        out << std::setw(8) << StressField::stepSize(step.stressStep) << std::setw(12) << spherePathName(step.path);
+        if (step.samples == 0)
+        {
+            out << std::setw(10) << "-" << "\n";
+            continue;
+        }
+        out << std::fixed << std::setprecision(3) << std::setw(10) << step.sumMs / step.samples
+            << std::setw(10) << step.minMs << std::setw(10) << step.maxMs << "\n";
+        out.unsetf(std::ios::floatfield);
+    }
+}
@@ -0,0 +1,60 @@
+#ifndef SPHEREBENCHMARK_H
+#define SPHEREBENCHMARK_H
+
+#include <ostream>
+#include <vector>
+
+// Ways the spheres can reach the GPU
+enum SpherePath
+{
+    SPHERE_PATH_MESH = 0,    // CPU-culled instanced LOD meshes (SphereBatch)
+    SPHERE_PATH_GPU_DRIVEN,  // compute-culled multi-draw (IndirectRenderer)
+    SPHERE_PATH_IMPOSTOR,    // ray-cast quads (SphereBatch::setImpostors)
+    SPHERE_PATH_COUNT
+};
+
+const char *spherePathName(int path);
+
+// Scripted run over every StressField size and sphere path. The caller
+// applies stressStep() and path() each frame and reports the scene pass GPU
+// time; the first WARMUP_FRAMES of each configuration are dropped (they
+// include the timer query latency and any buffer growth), the next
+// MEASURE_FRAMES are averaged, and printTable() writes one row per run.
+class SphereBenchmark
+{
+public:
+    static const int WARMUP_FRAMES = 60;
+    static const int MEASURE_FRAMES = 240;
+
+    // Paths the context can't run are skipped
+    void start(bool gpuDrivenSupported);
+    bool running() const { return m_running; }
+    // True once, on the frame the last configuration finished
+    bool justFinished();
+
+    int stressStep() const { return m_steps[m_current].stressStep; }
+    int path() const { return m_steps[m_current].path; }
+
+    // Scene pass GPU time for this frame; negative (not arrived yet) is ignored
+    void addFrame(float sceneMs);
+
+    void printTable(std::ostream &out) const;
+
+private:
+    struct Step
+    {
+        int stressStep;
+        int path;
+        int frames = 0; // including warm-up
+        int samples = 0;
+        double sumMs = 0.0;
+        float minMs = 0.0f, maxMs = 0.0f;
+    };
+
+    std::vector<Step> m_steps;
+    int m_current = 0;
+    bool m_running = false;
+    bool m_finished = false;
+};
+
+#endif
@@ -0,0 +1,118 @@
+#include "SphereMesh.h"
+#include <glm/glm.hpp>
+#include <glm/gtc/constants.hpp>
+#include <algorithm>
+#include <cmath>
+
+// Largest on-screen radius (pixels) each level covers before its facets show:
+// roughly one sector per 8 pixels of silhouette.
+static float levelMaxRadiusPx(int level)
+{
+    return (float)(8 << level) * 1.25f;
+}
+
+static const float LOD_HYSTERESIS = 0.15f;
+
+SphereMesh::SphereMesh()
+{
+    std::vector<float> &vertices = m_vertices;
+    std::vector<unsigned short> &indices = m_indices;
+
+    for (int l = 0; l < LEVEL_COUNT; ++l)
+    {
+        int sectorCount = 8 << l;
+        int stackCount = sectorCount / 2;
+
+        Level &lvl = m_levels[l];
+        lvl.sectors = sectorCount;
+        lvl.stacks = stackCount;
+        lvl.baseVertex = (GLint)(vertices.size() / 8);
+        lvl.firstIndexBytes = indices.size() * sizeof(unsigned short);
+
+        for (int i = 0; i <= stackCount; ++i)
+        {
+            float stackAngle = glm::pi<float>() / 2 - i * glm::pi<float>() / stackCount;
+            float xy = cos(stackAngle);
+            float z = sin(stackAngle);
+
+            for (int j = 0; j <= sectorCount; ++j)
+            {
+                float sectorAngle = j * 2 * glm::pi<float>() / sectorCount;
+                float x = xy * cos(sectorAngle);
+                float y = xy * sin(sectorAngle);
+
+                vertices.push_back(x);
+                vertices.push_back(y);
+                vertices.push_back(z);
+                vertices.push_back(x);
+                vertices.push_back(y);
+                vertices.push_back(z);
+                vertices.push_back((float)j / sectorCount);
+                vertices.push_back((float)i / stackCount);
+            }
+        }
+
+        // Local indices; the pole rows only get one triangle per sector
+        for (int i = 0; i < stackCount; ++i)
+        {
+            int k1 = i * (sectorCount + 1);
+            int k2 = k1 + sectorCount + 1;
+
+            for (int j = 0; j < sectorCount; ++j, ++k1, ++k2)
+            {
+                if (i != 0)
+                {
+                    indices.push_back((unsigned short)k1);
+                    indices.push_back((unsigned short)k2);
+                    indices.push_back((unsigned short)(k1 + 1));
+                }
+                if (i != stackCount - 1)
+                {
+                    indices.push_back((unsigned short)(k1 + 1));
+                    indices.push_back((unsigned short)k2);
+                    indices.push_back((unsigned short)(k2 + 1));
+                }
+            }
+        }
+
+        lvl.indexCount = (GLsizei)(indices.size() - lvl.firstIndexBytes / sizeof(unsigned short));
+    }
+
+    glGenVertexArrays(1, &m_vao);
+    glGenBuffers(1, &m_vbo);
+    glGenBuffers(1, &m_ebo);
+
+    glBindVertexArray(m_vao);
+    glBindBuffer(GL_ARRAY_BUFFER, m_vbo);
+    glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(float), vertices.data(), GL_STATIC_DRAW);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_ebo);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(unsigned short), indices.data(), GL_STATIC_DRAW);
+
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void *)0);
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void *)(3 * sizeof(float)));
+    glEnableVertexAttribArray(1);
+    glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void *)(6 * sizeof(float)));
+    glEnableVertexAttribArray(2);
+    glBindVertexArray(0);
+}
+
+SphereMesh::~SphereMesh()
+{
+    if (m_ebo)
+        glDeleteBuffers(1, &m_ebo);
+    if (m_vbo)
+        glDeleteBuffers(1, &m_vbo);
+    if (m_vao)
+        glDeleteVertexArrays(1, &m_vao);
+}
+
+int SphereMesh::selectLevel(float radiusPx, int current)
+{
+    int level = std::min(std::max(current, 0), LEVEL_COUNT - 1);
+    while (level < LEVEL_COUNT - 1 && radiusPx > levelMaxRadiusPx(level) * (1.0f + LOD_HYSTERESIS))
+        ++level;
+    while (level > 0 && radiusPx < levelMaxRadiusPx(level - 1) * (1.0f - LOD_HYSTERESIS))
+        --level;
+    return level;
+}
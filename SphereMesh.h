@@ -0,0 +1,45 @@
+#ifndef SPHEREMESH_H
+#define SPHEREMESH_H
+
+#include <vector>
+#include <cstddef>
+#include <GL/glew.h>
+
+// Indexed UV-sphere LOD chain, 8x4 up to 256x128 segments, packed into one
+// VBO/EBO pair. Each level is addressed by its first index and base vertex.
+class SphereMesh
+{
+public:
+    struct Level
+    {
+        int sectors, stacks;
+        GLsizei indexCount;
+        size_t firstIndexBytes;
+        GLint baseVertex;
+    };
+
+    static const int LEVEL_COUNT = 6;
+
+    SphereMesh();
+    ~SphereMesh();
+
+    GLuint vao() const { return m_vao; }
+    const Level &level(int i) const { return m_levels[i]; }
+
+    // CPU copies (pos, normal, uv floats; 16-bit level-local indices) for other vertex arenas
+    const std::vector<float> &vertexData() const { return m_vertices; }
+    const std::vector<unsigned short> &indexData() const { return m_indices; }
+
+    // Pick a level for a sphere covering `radiusPx` pixels on screen. `current`
+    // is the level used last frame; a band around each threshold keeps bodies
+    // near a boundary from flickering between levels.
+    static int selectLevel(float radiusPx, int current);
+
+private:
+    GLuint m_vao = 0, m_vbo = 0, m_ebo = 0;
+    Level m_levels[LEVEL_COUNT];
+    std::vector<float> m_vertices;
+    std::vector<unsigned short> m_indices;
+};
+
+#endif
@@ -0,0 +1,44 @@
+#include "SphereOccluders.h"
+#include <algorithm>
+#include <cmath>
+
+void SphereOccluders::begin(const glm::vec3 &eye)
+{
+    m_eye = eye;
+    m_occluders.clear();
+}
+
+void SphereOccluders::add(const glm::vec3 &center, float radius)
+{
+    glm::vec3 toCenter = center - m_eye;
+    float d = glm::length(toCenter);
+
+    // An occluder around the eye covers nothing it can be tested against
+    if (d <= radius)
+        return;
+    m_occluders.push_back(Occluder{toCenter / d, d, std::asin(radius / d)});
+}
+
+bool SphereOccluders::isOccluded(const glm::vec3 &center, float radius) const
+{
+    glm::vec3 toCenter = center - m_eye;
+    float d = glm::length(toCenter);
+    if (d <= radius)
+        return false;
+
+    glm::vec3 dir = toCenter / d;
+    float angle = std::asin(radius / d);
+
+    for (const Occluder &o : m_occluders)
+    {
+        // Must start behind the occluder's center, which is past its near surface
+        // along any ray inside its disc
+        if (d - radius < o.distance)
+            continue;
+
+        float theta = std::acos(std::min(std::max(glm::dot(dir, o.dir), -1.0f), 1.0f));
+        if (theta + angle <= o.angle)
+            return true;
+    }
+    return false;
+}
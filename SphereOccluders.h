@@ -0,0 +1,35 @@
+#ifndef SPHEREOCCLUDERS_H
+#define SPHEREOCCLUDERS_H
+
+#include <vector>
+#include <glm/glm.hpp>
+
+// A handful of large spheres (the Sun and the planets) seen from one eye point.
+// A sphere is occluded when its whole disc lies inside an occluder's disc and
+// it is entirely farther away than that occluder's center.
+class SphereOccluders
+{
+public:
+    struct Occluder
+    {
+        glm::vec3 dir;  // unit vector from the eye
+        float distance; // eye to center
+        float angle;    // angular radius
+    };
+
+    void begin(const glm::vec3 &eye);
+    void add(const glm::vec3 &center, float radius);
+
+    bool isOccluded(const glm::vec3 &center, float radius) const;
+    int size() const { return (int)m_occluders.size(); }
+
+    // For the same test on the GPU (see IndirectRenderer)
+    const glm::vec3 &eye() const { return m_eye; }
+    const Occluder &occluder(int i) const { return m_occluders[i]; }
+
+private:
+    glm::vec3 m_eye = glm::vec3(0.0f);
+    std::vector<Occluder> m_occluders;
+};
+
+#endif
@@ -0,0 +1,88 @@
+#include "SpriteBatch.h"
+#include "GLState.h"
+#include <cstddef>
+
+const float SpriteBatch::MAX_RADIUS_PX = 2.0f;
+
+static const float SPRITE_HYSTERESIS = 0.15f;
+
+SpriteBatch::SpriteBatch()
+    : m_stream(256 * sizeof(SpriteInstance))
+{
+    // One vertex per sprite; the pointers follow the stream offset at draw time
+    glGenVertexArrays(1, &m_vao);
+    glBindVertexArray(m_vao);
+    glEnableVertexAttribArray(0);
+    glEnableVertexAttribArray(1);
+    glBindVertexArray(0);
+}
+
+SpriteBatch::~SpriteBatch()
+{
+    if (m_vao)
+        glDeleteVertexArrays(1, &m_vao);
+}
+
+bool SpriteBatch::selectSprite(float radiusPx, bool current)
+{
+    float threshold = MAX_RADIUS_PX * (current ? 1.0f + SPRITE_HYSTERESIS : 1.0f - SPRITE_HYSTERESIS);
+    return radiusPx < threshold;
+}
+
+void SpriteBatch::clear()
+{
+    m_sprites.clear();
+    m_visible.clear();
+    m_culler.clear();
+}
+
+void SpriteBatch::add(const glm::vec3 &center, float radius, int layer, unsigned int flags)
+{
+    m_sprites.push_back(SpriteInstance{glm::vec4(center, radius), glm::vec4((float)layer, (float)flags, 0.0f, 0.0f)});
+    m_culler.add(center, radius);
+}
+
+void SpriteBatch::cull(const Frustum &frustum, const SphereOccluders *occluders)
+{
+    m_culler.cull(frustum, m_inFrustum);
+
+    m_visible.clear();
+    for (size_t i = 0; i < m_sprites.size(); ++i)
+    {
+        if (!m_inFrustum[i])
+            continue;
+        const glm::vec4 &center = m_sprites[i].center;
+        if (occluders && occluders->isOccluded(glm::vec3(center), center.w))
+            continue;
+        m_visible.push_back(m_sprites[i]);
+    }
+
+    if (!m_visible.empty())
+        m_streamOffset = m_stream.write(m_visible.data(), m_visible.size() * sizeof(SpriteInstance));
+}
+
+void SpriteBatch::submit(RenderQueue &queue, const DrawPacket &proto) const
+{
+    if (m_visible.empty())
+        return;
+
+    DrawPacket packet = proto;
+    packet.pass = RENDER_PASS_BLENDED;
+    packet.mesh = m_vao;
+    packet.draw = [this]() { draw(); };
+    queue.submit(packet);
+}
+
+void SpriteBatch::draw() const
+{
+    if (m_visible.empty())
+        return;
+
+    GLState::bindVertexArray(m_vao);
+    glBindBuffer(GL_ARRAY_BUFFER, m_stream.id());
+    glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, sizeof(SpriteInstance),
+                          (void *)(m_streamOffset + offsetof(SpriteInstance, center)));
+    glVertexAttribPointer(1, 4, GL_FLOAT, GL_FALSE, sizeof(SpriteInstance),
+                          (void *)(m_streamOffset + offsetof(SpriteInstance, params)));
+    glDrawArrays(GL_POINTS, 0, (GLsizei)m_visible.size());
+}
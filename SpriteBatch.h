@@ -0,0 +1,60 @@
+#ifndef SPRITEBATCH_H
+#define SPRITEBATCH_H
+
+#include <vector>
+#include <glm/glm.hpp>
+#include <GL/glew.h>
+#include "FrustumCuller.h"
+#include "SphereOccluders.h"
+#include "RenderQueue.h"
+#include "StreamBuffer.h"
+
+struct SpriteInstance
+{
+    glm::vec4 center; // xyz position, w radius
+    glm::vec4 params; // x = texture array layer, y = SphereFlags
+};
+
+// Bodies smaller than a couple of pixels on screen, drawn as one GL_POINTS
+// call instead of sphere meshes. sprite_vertex.glsl turns each point into the
+// light the whole sphere would reflect: its size, the mean albedo of its
+// texture and the Lambert phase function of the Sun-body-eye angle, so a body
+// fades out smoothly and shows its phase instead of popping.
+class SpriteBatch
+{
+public:
+    // Projected radius below which a body becomes a sprite
+    static const float MAX_RADIUS_PX;
+
+    SpriteBatch();
+    ~SpriteBatch();
+
+    // Same idea as SphereMesh::selectLevel: `current` is last frame's choice,
+    // and a band around the threshold keeps bodies from flickering
+    static bool selectSprite(float radiusPx, bool current);
+
+    void clear();
+    void add(const glm::vec3 &center, float radius, int layer, unsigned int flags);
+
+    // Keep the sprites inside `frustum` and not behind one of `occluders`, then upload them
+    void cull(const Frustum &frustum, const SphereOccluders *occluders = nullptr);
+
+    // Queue the draw (RENDER_PASS_BLENDED); `proto` supplies the shader and texture.
+    // The shader needs `pixelScale` (Camera::getPixelScale) set.
+    void submit(RenderQueue &queue, const DrawPacket &proto) const;
+    void draw() const;
+
+    int size() const { return (int)m_sprites.size(); }
+    int visibleCount() const { return (int)m_visible.size(); }
+
+private:
+    GLuint m_vao = 0;
+    StreamBuffer m_stream;
+    size_t m_streamOffset = 0;
+    std::vector<SpriteInstance> m_sprites;
+    std::vector<SpriteInstance> m_visible;
+    FrustumCuller m_culler;
+    std::vector<unsigned char> m_inFrustum;
+};
+
+#endif
@@ -0,0 +1,141 @@
+#include "StreamBuffer.h"
+#include <cstring>
+
+// Every live stream, so endFrame() can fence them all
+static StreamBuffer *s_streams = nullptr;
+
+static const GLuint64 FENCE_TIMEOUT_NS = 1000000000; // 1 s, then give up waiting
+
+StreamBuffer::StreamBuffer(size_t bytesPerFrame)
+{
+    m_persistent = GLEW_VERSION_4_4 || GLEW_ARB_buffer_storage;
+    allocate(bytesPerFrame);
+
+    m_next = s_streams;
+    s_streams = this;
+}
+
+StreamBuffer::~StreamBuffer()
+{
+    for (StreamBuffer **link = &s_streams; *link; link = &(*link)->m_next)
+    {
+        if (*link == this)
+        {
+            *link = m_next;
+            break;
+        }
+    }
+    release();
+}
+
+void StreamBuffer::allocate(size_t regionSize)
+{
+    m_regionSize = regionSize;
+    m_region = 0;
+    m_cursor = 0;
+    m_orphaned = false;
+
+    // GL_COPY_WRITE_BUFFER: no VAO, draw or indexed binding is disturbed
+    glGenBuffers(1, &m_buffer);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, m_buffer);
+    if (m_persistent)
+    {
+        GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+        glBufferStorage(GL_COPY_WRITE_BUFFER, (GLsizeiptr)(m_regionSize * FRAMES), nullptr, flags);
+        m_mapped = (unsigned char *)glMapBufferRange(GL_COPY_WRITE_BUFFER, 0, (GLsizeiptr)(m_regionSize * FRAMES), flags);
+    }
+    else
+    {
+        glBufferData(GL_COPY_WRITE_BUFFER, (GLsizeiptr)m_regionSize, nullptr, GL_STREAM_DRAW);
+    }
+    glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+}
+
+void StreamBuffer::release()
+{
+    for (GLsync &fence : m_fences)
+    {
+        if (fence)
+            glDeleteSync(fence);
+        fence = nullptr;
+    }
+    if (m_buffer)
+    {
+        // Deleting also unmaps; draws already queued keep the old storage alive
+        glDeleteBuffers(1, &m_buffer);
+        m_buffer = 0;
+    }
+    m_mapped = nullptr;
+}
+
+size_t StreamBuffer::write(const void *data, size_t bytes, size_t alignment)
+{
+    size_t offset = (m_cursor + alignment - 1) / alignment * alignment;
+    if (offset + bytes > m_regionSize)
+    {
+        grow(bytes);
+        offset = 0;
+    }
+
+    if (m_persistent)
+    {
+        size_t absolute = (size_t)m_region * m_regionSize + offset;
+        std::memcpy(m_mapped + absolute, data, bytes);
+        m_cursor = offset + bytes;
+        return absolute;
+    }
+
+    glBindBuffer(GL_COPY_WRITE_BUFFER, m_buffer);
+    if (!m_orphaned)
+    {
+        // New storage for this frame; the old one lives on for pending draws
+        glBufferData(GL_COPY_WRITE_BUFFER, (GLsizeiptr)m_regionSize, nullptr, GL_STREAM_DRAW);
+        m_orphaned = true;
+    }
+    glBufferSubData(GL_COPY_WRITE_BUFFER, (GLintptr)offset, (GLsizeiptr)bytes, data);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+    m_cursor = offset + bytes;
+    return offset;
+}
+
+void StreamBuffer::reserve(size_t bytes)
+{
+    if (m_cursor + bytes > m_regionSize)
+        grow(bytes);
+}
+
+void StreamBuffer::grow(size_t needed)
+{
+    // Outgrew the region: start over in a bigger buffer
+    size_t regionSize = m_regionSize;
+    while (regionSize < needed)
+        regionSize *= 2;
+    release();
+    allocate(regionSize);
+}
+
+void StreamBuffer::advance()
+{
+    m_cursor = 0;
+    m_orphaned = false;
+    if (!m_persistent)
+        return;
+
+    m_fences[m_region] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    m_region = (m_region + 1) % FRAMES;
+
+    // Normally signalled long ago; only a GPU running FRAMES behind waits here
+    GLsync &fence = m_fences[m_region];
+    if (fence)
+    {
+        glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, FENCE_TIMEOUT_NS);
+        glDeleteSync(fence);
+        fence = nullptr;
+    }
+}
+
+void StreamBuffer::endFrame()
+{
+    for (StreamBuffer *stream = s_streams; stream; stream = stream->m_next)
+        stream->advance();
+}
@@ -0,0 +1,56 @@
+#ifndef STREAMBUFFER_H
+#define STREAMBUFFER_H
+
+#include <cstddef>
+#include <GL/glew.h>
+
+// Ring buffer for data rewritten every frame (HUD text, instances, draw
+// records). With GL 4.4 / ARB_buffer_storage it is mapped once, persistently,
+// and split into FRAMES regions; a fence per region keeps the CPU from
+// overwriting data the GPU has not read yet. Older contexts orphan the
+// storage on the first write of each frame instead.
+//
+// Callers bind id() and use the returned offsets right after write(); the
+// buffer may be reallocated (new id) when a frame outgrows its region.
+// reserve() first when several writes must land in the same buffer.
+class StreamBuffer
+{
+public:
+    static const int FRAMES = 3;
+
+    explicit StreamBuffer(size_t bytesPerFrame);
+    ~StreamBuffer();
+
+    // Copy `bytes` into this frame's region; returns the byte offset in id()
+    size_t write(const void *data, size_t bytes, size_t alignment = 16);
+    // Make room for `bytes` more (padding included) without reallocating in between
+    void reserve(size_t bytes);
+
+    GLuint id() const { return m_buffer; }
+    bool persistent() const { return m_persistent; }
+
+    // Fence every stream's region and move on to the next one; call once per
+    // frame after the last draw (next to GLState::endFrame)
+    static void endFrame();
+
+private:
+    GLuint m_buffer = 0;
+    bool m_persistent = false;
+    size_t m_regionSize = 0;
+    size_t m_cursor = 0;       // bytes used in the current region
+    int m_region = 0;
+    unsigned char *m_mapped = nullptr;
+    GLsync m_fences[FRAMES] = {};
+    bool m_orphaned = false;   // fallback: storage already renewed this frame
+    StreamBuffer *m_next = nullptr;
+
+    StreamBuffer(const StreamBuffer &) = delete;
+    StreamBuffer &operator=(const StreamBuffer &) = delete;
+
+    void grow(size_t needed);
+    void allocate(size_t regionSize);
+    void release();
+    void advance();
+};
+
+#endif
@@ -0,0 +1,43 @@
+#include "StressField.h"
+#include "SphereMesh.h"
+#include <glm/gtc/constants.hpp>
+#include <cmath>
+#include <random>
+
+int StressField::stepSize(int step)
+{
+    static const int SIZES[STEP_COUNT] = {0, 1000, 10000, 100000};
+    return SIZES[step % STEP_COUNT];
+}
+
+void StressField::resize(int count, int layerCount)
+{
+    // Same seed every time, so runs at the same size draw the same scene
+    std::mt19937 rng(1234u);
+    std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+
+    m_transforms.resize(count);
+    m_layers.resize(count);
+    m_lods.assign(count, 0);
+    for (int i = 0; i < count; ++i)
+    {
+        float angle = unit(rng) * glm::two_pi<float>();
+        float distance = 30.0f + unit(rng) * 120.0f;
+        glm::vec3 position(std::cos(angle) * distance, (unit(rng) - 0.5f) * 40.0f, std::sin(angle) * distance);
+        m_transforms.set(i, position, unit(rng) * glm::two_pi<float>(), 0.2f + unit(rng) * 0.6f);
+        m_layers[i] = layerCount > 0 ? (int)(unit(rng) * layerCount) % layerCount : 0;
+    }
+    m_transforms.compute();
+}
+
+void StressField::append(SphereBatch &batch, const glm::vec3 &eye, float pixelScale)
+{
+    for (int i = 0; i < m_transforms.size(); ++i)
+    {
+        float radius = m_transforms.scale(i);
+        float dist = glm::length(m_transforms.position(i) - eye);
+        float radiusPx = (dist > radius) ? radius / dist * pixelScale : 1e6f;
+        m_lods[i] = SphereMesh::selectLevel(radiusPx, m_lods[i]);
+        batch.add(m_transforms.model(i), m_transforms.normal(i), m_layers[i], 0, m_lods[i]);
+    }
+}
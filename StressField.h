@@ -0,0 +1,32 @@
+#ifndef STRESSFIELD_H
+#define STRESSFIELD_H
+
+#include <vector>
+#include <glm/glm.hpp>
+#include "SphereBatch.h"
+#include "TransformBatch.h"
+
+// Synthetic bodies for comparing the sphere paths (mesh LOD, GPU-driven,
+// impostors) at catalog sizes: a fixed, seeded shell of small textured
+// spheres around the system, added to the batch every frame. They never
+// become sprites, so every one of them goes through the path being measured.
+class StressField
+{
+public:
+    // Sizes the benchmark steps through (0 = off)
+    static const int STEP_COUNT = 4;
+    static int stepSize(int step);
+
+    // Lay out `count` spheres over texture layers [0, layerCount)
+    void resize(int count, int layerCount);
+    void append(SphereBatch &batch, const glm::vec3 &eye, float pixelScale);
+
+    int size() const { return m_transforms.size(); }
+
+private:
+    TransformBatch m_transforms;
+    std::vector<int> m_layers;
+    std::vector<int> m_lods;
+};
+
+#endif
@@ -16,26 +16,6 @@ void Sun::update(float deltaTime)
     m_rotation.y = m_time * m_rotationSpeed;
 }
 
-void Sun::render(Shader &shader, unsigned int sphereVAO, int vertexCount)
-{
-    if (m_texture)
-    {
-        glActiveTexture(GL_TEXTURE0);
-        m_texture->bind();
-        shader.setInt("texture1", 0);
-    }
-
-    // Set model matrix
-    shader.setMat4("model", getModelMatrix());
-
-    // Sun is the light source
-    shader.setVec3("lightPos", m_position);
-
-    // Render the sphere
-    glBindVertexArray(sphereVAO);
-    glDrawArrays(GL_TRIANGLES, 0, vertexCount);
-}
-
 glm::mat4 Sun::getModelMatrix() const
 {
     glm::mat4 model = glm::mat4(1.0f);
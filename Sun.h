@@ -9,8 +9,8 @@ public:
     Sun(const std::string &texturePath = "assets/textures/sun.jpg");
 
     void update(float deltaTime) override;
-    void render(Shader &shader, unsigned int sphereVAO, int vertexCount) override;
     glm::mat4 getModelMatrix() const override;
+    unsigned int sphereFlags() const override { return SPHERE_EMISSIVE; }
 
 private:
     float m_time;
@@ -1,4 +1,5 @@
 #include "Texture.h"
+#include "GLState.h"
 #include <iostream>
 #define STB_IMAGE_IMPLEMENTATION
 #include "stb_image.h"
@@ -35,5 +36,5 @@ Texture::Texture(const std::string &path)
 
 void Texture::bind() const
 {
-    glBindTexture(GL_TEXTURE_2D, ID);
+    GLState::bindTexture(GL_TEXTURE_2D, ID);
 }
@@ -0,0 +1,93 @@
+#include "TextureArray.h"
+#include "GLState.h"
+#include <iostream>
+
+TextureArray::TextureArray(int layerWidth, int layerHeight)
+    : m_width(layerWidth), m_height(layerHeight)
+{
+}
+
+TextureArray::~TextureArray()
+{
+    if (ID)
+        glDeleteTextures(1, &ID);
+}
+
+int TextureArray::addLayer(const std::string &key, const Texture *source)
+{
+    auto it = m_layerByKey.find(key);
+    if (it != m_layerByKey.end())
+        return it->second;
+
+    int layer = (int)m_sources.size();
+    m_sources.push_back(source);
+    m_layerByKey.emplace(key, layer);
+    return layer;
+}
+
+void TextureArray::build()
+{
+    if (m_sources.empty())
+        return;
+
+    if (!ID)
+        glGenTextures(1, &ID);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, ID);
+    glTexImage3D(GL_TEXTURE_2D_ARRAY, 0, GL_RGBA8, m_width, m_height, (GLsizei)m_sources.size(),
+                 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+
+    // Resample each source into its layer on the GPU
+    GLuint fbo[2];
+    glGenFramebuffers(2, fbo);
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, fbo[0]);
+    glBindFramebuffer(GL_DRAW_FRAMEBUFFER, fbo[1]);
+
+    for (int layer = 0; layer < (int)m_sources.size(); ++layer)
+    {
+        glFramebufferTextureLayer(GL_DRAW_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, ID, 0, layer);
+
+        bool copied = false;
+        const Texture *src = m_sources[layer];
+        if (src)
+        {
+            GLint w = 0, h = 0;
+            glBindTexture(GL_TEXTURE_2D, src->ID);
+            glGetTexLevelParameteriv(GL_TEXTURE_2D, 0, GL_TEXTURE_WIDTH, &w);
+            glGetTexLevelParameteriv(GL_TEXTURE_2D, 0, GL_TEXTURE_HEIGHT, &h);
+            if (w > 0 && h > 0)
+            {
+                glFramebufferTexture2D(GL_READ_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, src->ID, 0);
+                if (glCheckFramebufferStatus(GL_READ_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE)
+                {
+                    glBlitFramebuffer(0, 0, w, h, 0, 0, m_width, m_height, GL_COLOR_BUFFER_BIT, GL_LINEAR);
+                    copied = true;
+                }
+            }
+        }
+        if (!copied)
+        {
+            const GLfloat grey[4] = {0.5f, 0.5f, 0.5f, 1.0f};
+            glClearBufferfv(GL_COLOR, 0, grey);
+        }
+    }
+
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    glDeleteFramebuffers(2, fbo);
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    glBindTexture(GL_TEXTURE_2D_ARRAY, ID);
+    glGenerateMipmap(GL_TEXTURE_2D_ARRAY);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+
+    std::cout << "Texture array built: " << m_sources.size() << " layers at "
+              << m_width << "x" << m_height << std::endl;
+}
+
+void TextureArray::bind() const
+{
+    GLState::bindTexture(GL_TEXTURE_2D_ARRAY, ID);
+}
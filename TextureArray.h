@@ -0,0 +1,37 @@
+#ifndef TEXTUREARRAY_H
+#define TEXTUREARRAY_H
+
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <GL/glew.h>
+#include "Texture.h"
+
+// GL_TEXTURE_2D_ARRAY holding one layer per distinct texture. Sources of any
+// size are resampled to the array's layer size with a framebuffer blit, so
+// every sphere can sample from a single binding.
+class TextureArray
+{
+public:
+    GLuint ID = 0;
+
+    TextureArray(int layerWidth, int layerHeight);
+    ~TextureArray();
+
+    // Reserve a layer for `source`; repeated keys share one layer.
+    // A null or unloaded source becomes a flat grey layer.
+    int addLayer(const std::string &key, const Texture *source);
+
+    // Allocate storage and copy every pending source. Call once after all addLayer calls.
+    void build();
+
+    void bind() const;
+    int layerCount() const { return (int)m_sources.size(); }
+
+private:
+    int m_width, m_height;
+    std::vector<const Texture *> m_sources;
+    std::unordered_map<std::string, int> m_layerByKey;
+};
+
+#endif
@@ -0,0 +1,89 @@
+#include "ThreadPool.h"
+#include <algorithm>
+
+ThreadPool::ThreadPool(unsigned threads)
+{
+    if (threads == 0)
+    {
+        unsigned hw = std::thread::hardware_concurrency();
+        threads = hw > 1 ? hw - 1 : 1;
+    }
+    for (unsigned i = 0; i < threads; ++i)
+        m_workers.emplace_back(&ThreadPool::workerLoop, this);
+}
+
+ThreadPool::~ThreadPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stop = true;
+    }
+    m_cv.notify_all();
+    for (auto &t : m_workers)
+        t.join();
+}
+
+void ThreadPool::submit(std::function<void()> job)
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_jobs.push_back(std::move(job));
+    }
+    m_cv.notify_one();
+}
+
+void ThreadPool::workerLoop()
+{
+    for (;;)
+    {
+        std::function<void()> job;
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_cv.wait(lock, [this]
+                      { return m_stop || !m_jobs.empty(); });
+            if (m_stop && m_jobs.empty())
+                return;
+            job = std::move(m_jobs.front());
+            m_jobs.pop_front();
+        }
+        job();
+    }
+}
+
+void ThreadPool::parallelFor(int count, const std::function<void(int, int, int)> &fn)
+{
+    if (count <= 0)
+        return;
+
+    int chunks = std::min((int)slots(), count);
+    if (chunks == 1)
+    {
+        fn(0, count, 0);
+        return;
+    }
+
+    std::mutex doneMutex;
+    std::condition_variable doneCv;
+    int pending = chunks - 1;
+
+    int per = (count + chunks - 1) / chunks;
+    for (int c = 1; c < chunks; ++c)
+    {
+        int begin = c * per;
+        int end = std::min(count, begin + per);
+        submit([&, begin, end, c]
+               {
+                   if (begin < end)
+                       fn(begin, end, c);
+                   std::lock_guard<std::mutex> lock(doneMutex);
+                   if (--pending == 0)
+                       doneCv.notify_one(); });
+    }
+
+    // The caller takes the first range instead of idling
+    fn(0, std::min(count, per), 0);
+
+    std::unique_lock<std::mutex> lock(doneMutex);
+    doneCv.wait(lock, [&]
+                { return pending == 0; });
+}
@@ -0,0 +1,42 @@
+#ifndef THREADPOOL_H
+#define THREADPOOL_H
+
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+
+// Fixed set of worker threads fed from a FIFO job queue.
+class ThreadPool
+{
+public:
+    // threads = 0 picks hardware_concurrency - 1 (the caller is the extra thread)
+    explicit ThreadPool(unsigned threads = 0);
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool &) = delete;
+    ThreadPool &operator=(const ThreadPool &) = delete;
+
+    // Fire-and-forget job
+    void submit(std::function<void()> job);
+
+    // Split [0, count) into contiguous ranges, one per worker plus the calling
+    // thread, and block until all of them finished. fn(begin, end, slot) gets a
+    // slot in [0, slots()) that is unique for the duration of the call.
+    void parallelFor(int count, const std::function<void(int, int, int)> &fn);
+
+    unsigned slots() const { return (unsigned)m_workers.size() + 1; }
+
+private:
+    std::vector<std::thread> m_workers;
+    std::deque<std::function<void()>> m_jobs;
+    std::mutex m_mutex;
+    std::condition_variable m_cv;
+    bool m_stop = false;
+
+    void workerLoop();
+};
+
+#endif
@@ -0,0 +1,172 @@
+#include "TransformBatch.h"
+#include <cmath>
+#include <cstring>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define TRANSFORM_SSE2 1
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define TRANSFORM_NEON 1
+#endif
+
+NormalMatrix NormalMatrix::fromModel(const glm::mat4 &model)
+{
+    glm::mat3 n = glm::transpose(glm::inverse(glm::mat3(model)));
+    NormalMatrix result;
+    for (int col = 0; col < 3; ++col)
+        result.columns[col] = glm::vec4(n[col], 0.0f);
+    return result;
+}
+
+glm::mat3 NormalMatrix::toMat3() const
+{
+    return glm::mat3(glm::vec3(columns[0]), glm::vec3(columns[1]), glm::vec3(columns[2]));
+}
+
+void TransformBatch::resize(int count)
+{
+    m_count = count;
+    size_t padded = (size_t)(count + 3) / 4 * 4;
+    m_x.assign(padded, 0.0f);
+    m_y.assign(padded, 0.0f);
+    m_z.assign(padded, 0.0f);
+    m_rotation.assign(padded, 0.0f);
+    m_scale.assign(padded, 1.0f);
+    m_cos.resize(padded);
+    m_sin.resize(padded);
+    m_models.resize(padded);
+    m_normals.resize(padded);
+}
+
+void TransformBatch::set(int i, const glm::vec3 &position, float rotationY, float scale)
+{
+    m_x[i] = position.x;
+    m_y[i] = position.y;
+    m_z[i] = position.z;
+    m_rotation[i] = rotationY;
+    m_scale[i] = scale;
+}
+
+#if defined(TRANSFORM_SSE2)
+// Lane k of a, b, c, d becomes the 4 floats at dst[k]
+static inline void scatterColumns(float *const dst[4], __m128 a, __m128 b, __m128 c, __m128 d)
+{
+    _MM_TRANSPOSE4_PS(a, b, c, d);
+    _mm_storeu_ps(dst[0], a);
+    _mm_storeu_ps(dst[1], b);
+    _mm_storeu_ps(dst[2], c);
+    _mm_storeu_ps(dst[3], d);
+}
+#elif defined(TRANSFORM_NEON)
+static inline void scatterColumns(float *const dst[4], float32x4_t a, float32x4_t b, float32x4_t c, float32x4_t d)
+{
+    // vst4q interleaves the lanes: tmp[4k..4k+3] = (a[k], b[k], c[k], d[k])
+    float tmp[16];
+    float32x4x4_t columns = {{a, b, c, d}};
+    vst4q_f32(tmp, columns);
+    for (int k = 0; k < 4; ++k)
+        std::memcpy(dst[k], tmp + 4 * k, 4 * sizeof(float));
+}
+#endif
+
+void TransformBatch::compute()
+{
+    int n = (int)m_x.size();
+    for (int i = 0; i < n; ++i)
+    {
+        m_cos[i] = std::cos(m_rotation[i]);
+        m_sin[i] = std::sin(m_rotation[i]);
+    }
+
+    // model = T * Ry * S:  columns (kc, 0, -ks), (0, k, 0), (ks, 0, kc), (x, y, z)
+    // normal = Ry / k:     columns (c/k, 0, -s/k), (0, 1/k, 0), (s/k, 0, c/k)
+#if defined(TRANSFORM_SSE2)
+    const __m128 zero = _mm_setzero_ps();
+    const __m128 one = _mm_set1_ps(1.0f);
+    for (int i = 0; i < n; i += 4)
+    {
+        __m128 k = _mm_loadu_ps(&m_scale[i]);
+        __m128 c = _mm_loadu_ps(&m_cos[i]);
+        __m128 s = _mm_loadu_ps(&m_sin[i]);
+        __m128 inv = _mm_div_ps(one, k);
+        __m128 kc = _mm_mul_ps(k, c), ks = _mm_mul_ps(k, s);
+        __m128 nc = _mm_mul_ps(inv, c), ns = _mm_mul_ps(inv, s);
+
+        for (int col = 0; col < 4; ++col)
+        {
+            float *dst[4] = {&m_models[i][col][0], &m_models[i + 1][col][0],
+                             &m_models[i + 2][col][0], &m_models[i + 3][col][0]};
+            if (col == 0)
+                scatterColumns(dst, kc, zero, _mm_sub_ps(zero, ks), zero);
+            else if (col == 1)
+                scatterColumns(dst, zero, k, zero, zero);
+            else if (col == 2)
+                scatterColumns(dst, ks, zero, kc, zero);
+            else
+                scatterColumns(dst, _mm_loadu_ps(&m_x[i]), _mm_loadu_ps(&m_y[i]), _mm_loadu_ps(&m_z[i]), one);
+        }
+        for (int col = 0; col < 3; ++col)
+        {
+            float *dst[4] = {&m_normals[i].columns[col].x, &m_normals[i + 1].columns[col].x,
+                             &m_normals[i + 2].columns[col].x, &m_normals[i + 3].columns[col].x};
+            if (col == 0)
+                scatterColumns(dst, nc, zero, _mm_sub_ps(zero, ns), zero);
+            else if (col == 1)
+                scatterColumns(dst, zero, inv, zero, zero);
+            else
+                scatterColumns(dst, ns, zero, nc, zero);
+        }
+    }
+#elif defined(TRANSFORM_NEON)
+    const float32x4_t zero = vdupq_n_f32(0.0f);
+    const float32x4_t one = vdupq_n_f32(1.0f);
+    for (int i = 0; i < n; i += 4)
+    {
+        float32x4_t k = vld1q_f32(&m_scale[i]);
+        float32x4_t c = vld1q_f32(&m_cos[i]);
+        float32x4_t s = vld1q_f32(&m_sin[i]);
+        // Reciprocal estimate plus two Newton steps: full float precision
+        float32x4_t inv = vrecpeq_f32(k);
+        inv = vmulq_f32(inv, vrecpsq_f32(k, inv));
+        inv = vmulq_f32(inv, vrecpsq_f32(k, inv));
+        float32x4_t kc = vmulq_f32(k, c), ks = vmulq_f32(k, s);
+        float32x4_t nc = vmulq_f32(inv, c), ns = vmulq_f32(inv, s);
+
+        for (int col = 0; col < 4; ++col)
+        {
+            float *dst[4] = {&m_models[i][col][0], &m_models[i + 1][col][0],
+                             &m_models[i + 2][col][0], &m_models[i + 3][col][0]};
+            if (col == 0)
+                scatterColumns(dst, kc, zero, vnegq_f32(ks), zero);
+            else if (col == 1)
+                scatterColumns(dst, zero, k, zero, zero);
+            else if (col == 2)
+                scatterColumns(dst, ks, zero, kc, zero);
+            else
+                scatterColumns(dst, vld1q_f32(&m_x[i]), vld1q_f32(&m_y[i]), vld1q_f32(&m_z[i]), one);
+        }
+        for (int col = 0; col < 3; ++col)
+        {
+            float *dst[4] = {&m_normals[i].columns[col].x, &m_normals[i + 1].columns[col].x,
+                             &m_normals[i + 2].columns[col].x, &m_normals[i + 3].columns[col].x};
+            if (col == 0)
+                scatterColumns(dst, nc, zero, vnegq_f32(ns), zero);
+            else if (col == 1)
+                scatterColumns(dst, zero, inv, zero, zero);
+            else
+                scatterColumns(dst, ns, zero, nc, zero);
+        }
+    }
+#else
+    for (int i = 0; i < n; ++i)
+    {
+        float k = m_scale[i], c = m_cos[i], s = m_sin[i], inv = 1.0f / k;
+        m_models[i] = glm::mat4(glm::vec4(k * c, 0.0f, -k * s, 0.0f), glm::vec4(0.0f, k, 0.0f, 0.0f),
+                                glm::vec4(k * s, 0.0f, k * c, 0.0f), glm::vec4(m_x[i], m_y[i], m_z[i], 1.0f));
+        m_normals[i].columns[0] = glm::vec4(inv * c, 0.0f, -inv * s, 0.0f);
+        m_normals[i].columns[1] = glm::vec4(0.0f, inv, 0.0f, 0.0f);
+        m_normals[i].columns[2] = glm::vec4(inv * s, 0.0f, inv * c, 0.0f);
+    }
+#endif
+}
@@ -0,0 +1,44 @@
+#ifndef TRANSFORMBATCH_H
+#define TRANSFORMBATCH_H
+
+#include <vector>
+#include <glm/glm.hpp>
+
+// Normal matrix (transpose of the inverse of the model's upper 3x3) as three
+// columns padded to vec4, the stride instance attributes and std430 use
+struct NormalMatrix
+{
+    glm::vec4 columns[3];
+
+    // General case for one-off transforms (OBJ models, terrain)
+    static NormalMatrix fromModel(const glm::mat4 &model);
+    glm::mat3 toMat3() const;
+};
+
+// Model and normal matrices of every body for the frame, built once and
+// shared by both passes and picking. Bodies are all translate * rotateY *
+// uniform scale, kept as structure-of-arrays so the matrices of four bodies
+// are assembled per SIMD instruction (SSE2 or NEON, scalar elsewhere).
+class TransformBatch
+{
+public:
+    void resize(int count);
+    void set(int i, const glm::vec3 &position, float rotationY, float scale);
+    void compute();
+
+    int size() const { return m_count; }
+    const glm::mat4 &model(int i) const { return m_models[i]; }
+    const NormalMatrix &normal(int i) const { return m_normals[i]; }
+    glm::vec3 position(int i) const { return glm::vec3(m_x[i], m_y[i], m_z[i]); }
+    float scale(int i) const { return m_scale[i]; }
+
+private:
+    int m_count = 0;
+    // Padded to a multiple of 4; padding lanes hold an identity transform
+    std::vector<float> m_x, m_y, m_z, m_rotation, m_scale;
+    std::vector<float> m_cos, m_sin;
+    std::vector<glm::mat4> m_models;
+    std::vector<NormalMatrix> m_normals;
+};
+
+#endif
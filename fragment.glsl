@@ -1,22 +1,43 @@
 #version 330 core
+// Permutations (see ShaderPermutations): SHADOWS, ATMOSPHERE, EMISSIVE, INSTANCED, IMPOSTOR
 out vec4 FragColor;
 
 in vec3 FragPos;
-in vec3 Normal;
+#ifdef IMPOSTOR
+flat in vec3 Center;
+flat in float Radius;
+flat in mat3 WorldToLocal;
+#else
 in vec2 TexCoords;
+#ifndef EMISSIVE
+in vec3 Normal;
+#endif
+#ifdef SHADOWS
 in vec4 FragPosLightSpace;
+#endif
+#endif
+#ifdef INSTANCED
+flat in float Layer;
+flat in int Flags;
+
+uniform sampler2DArray textureLayers; // One layer per body texture
+#else
+uniform sampler2D texture_diffuse1;   // Model texture
+#endif
+#ifdef SHADOWS
+uniform sampler2D shadowMap;          // Shadow depth map
+#endif
 
-uniform sampler2D texture_diffuse1;  // Planet texture
-uniform sampler2D shadowMap;         // Shadow depth map
-uniform vec3 lightPos;               // Sun position
-uniform vec3 viewPos;                // Camera position
+// Camera and Lighting blocks and SceneDepth() come from FrameUniforms::prelude()
 
-// Atmosphere
-uniform vec3 atmosphereColor;        // Glow color
-uniform float atmosphereIntensity;   // Glow strength
+const int SPHERE_EMISSIVE = 1;
+const int SPHERE_SKY = 2;
+const int SPHERE_UNTEXTURED = 4;
+const float PI = 3.14159265;
 
+#ifdef SHADOWS
 // Shadow calculation
-float ShadowCalculation(vec4 fragPosLightSpace)
+float ShadowCalculation(vec4 fragPosLightSpace, vec3 fragPos, vec3 normal)
 {
     // Transform to normalized device coordinates
     vec3 projCoords = fragPosLightSpace.xyz / fragPosLightSpace.w;
@@ -26,44 +47,119 @@ float ShadowCalculation(vec4 fragPosLightSpace)
     if (projCoords.z > 1.0)
         return 0.0;
 
-    // Retrieve closest depth value from shadow map
-    float closestDepth = texture(shadowMap, projCoords.xy).r;  
+    float closestDepth = texture(shadowMap, projCoords.xy).r;
     float currentDepth = projCoords.z;
 
     // Bias to reduce shadow acne
-    float bias = max(0.005 * (1.0 - dot(Normal, normalize(lightPos - FragPos))), 0.0005);
+    float bias = max(0.005 * (1.0 - dot(normal, normalize(lightPos - fragPos))), 0.0005);
+    return currentDepth - bias > closestDepth ? 1.0 : 0.0;
+}
+#endif
 
-    // Apply shadow
-    float shadow = currentDepth - bias > closestDepth ? 1.0 : 0.0;
-    return shadow;
+vec3 BaseColor(vec2 texCoords)
+{
+#ifdef INSTANCED
+    if ((Flags & SPHERE_UNTEXTURED) != 0)
+        return vec3(1.0);
+    return texture(textureLayers, vec3(texCoords, Layer)).rgb;
+#else
+    return texture(texture_diffuse1, texCoords).rgb;
+#endif
 }
 
+#ifdef IMPOSTOR
+// Window-space depth of a world point, as the vertex path would have written it
+float ImpostorDepth(vec3 position)
+{
+    vec4 clipPos = projection * view * vec4(position, 1.0);
+    if (depthParams.x == 1.0) // reversed-Z, [0, 1] clip range
+        return clipPos.z / clipPos.w;
+    if (depthParams.x == 2.0) // logarithmic: NDC = log2(1 + w) * coefficient - 1
+        return log2(max(1e-6, 1.0 + clipPos.w)) * depthParams.y * 0.5;
+    return clipPos.z / clipPos.w * 0.5 + 0.5;
+}
+#endif
+
 void main()
 {
-    // Base texture color
-    vec3 color = texture(texture_diffuse1, TexCoords).rgb;
-    vec3 normal = normalize(Normal);
+#ifdef IMPOSTOR
+    // Exact hit of the pixel's ray with the sphere; the sky is seen from inside.
+    // Misses are discarded only after texturing, which needs the whole pixel quad.
+    vec3 rayDir = normalize(FragPos - viewPos);
+    vec3 offset = viewPos - Center;
+    float b = dot(rayDir, offset);
+    float h = b * b - (dot(offset, offset) - Radius * Radius);
+    bool sky = (Flags & SPHERE_SKY) != 0;
+    float t = sky ? -b + sqrt(max(h, 0.0)) : -b - sqrt(max(h, 0.0));
+    bool miss = h < 0.0 || t < 0.0;
+
+    vec3 fragPos = viewPos + t * rayDir;
+    vec3 surfaceNormal = (fragPos - Center) / Radius;
+
+    // Same parameterisation as SphereMesh: z is the pole axis of the mesh.
+    // Of the two u ranges, take the one without a jump in this pixel quad, so
+    // the seam doesn't drop to the smallest mip level.
+    vec3 local = normalize(WorldToLocal * (fragPos - Center));
+    float uCentered = atan(local.y, local.x) / (2.0 * PI);
+    float uWrapped = fract(uCentered);
+    float u = fwidth(uCentered) < fwidth(uWrapped) - 1e-4 ? uCentered : uWrapped;
+    vec2 texCoords = vec2(u, acos(clamp(local.z, -1.0, 1.0)) / PI);
+
+    gl_FragDepth = sky ? depthParams.z : ImpostorDepth(fragPos);
+#ifdef SHADOWS
+    vec4 fragPosLightSpace = lightSpaceMatrix * vec4(fragPos, 1.0);
+#endif
+#else
+    vec3 fragPos = FragPos;
+    vec2 texCoords = TexCoords;
+#ifndef EMISSIVE
+    vec3 surfaceNormal = Normal;
+#endif
+#ifdef SHADOWS
+    vec4 fragPosLightSpace = FragPosLightSpace;
+#endif
+#endif
+
+    vec3 color = BaseColor(texCoords);
+#ifdef IMPOSTOR
+    if (miss)
+        discard;
+#endif
+
+#ifdef EMISSIVE
+    // The Sun and the star sphere are their own light
+    FragColor = vec4(color, 1.0);
+#else
+#ifdef INSTANCED
+    // The indirect path draws every body with one program, so it still branches
+    if ((Flags & (SPHERE_EMISSIVE | SPHERE_SKY)) != 0)
+    {
+        FragColor = vec4(color, 1.0);
+        return;
+    }
+#endif
+
+    vec3 normal = normalize(surfaceNormal);
 
     // Lighting calculations
-    vec3 lightDir = normalize(lightPos - FragPos);
+    vec3 lightDir = normalize(lightPos - fragPos);
     float diff = max(dot(normal, lightDir), 0.0);
     vec3 diffuse = diff * color;
-
-    // Ambient light
     vec3 ambient = 0.2 * color;
 
-    // Calculate shadow factor
-    float shadow = ShadowCalculation(FragPosLightSpace);
+    float shadow = 0.0;
+#ifdef SHADOWS
+    shadow = ShadowCalculation(fragPosLightSpace, fragPos, normal);
+#endif
+    vec3 lighting = ambient + (1.0 - shadow) * diffuse;
 
-    // Combine ambient and diffuse lighting
-    vec3 lighting = (ambient + (1.0 - shadow) * diffuse);
-
-    // Calculate atmosphere glow using Fresnel effect
-    vec3 viewDir = normalize(viewPos - FragPos);
+#ifdef ATMOSPHERE
+    // Atmosphere glow using Fresnel effect
+    vec3 viewDir = normalize(viewPos - fragPos);
     float fresnel = pow(1.0 - max(dot(viewDir, normal), 0.0), 3.0);
-    vec3 atmosphere = atmosphereColor * fresnel * atmosphereIntensity;
+    lighting += atmosphereColor * fresnel * atmosphereIntensity;
+#endif
 
-    // Final color
-    vec3 finalColor = lighting + atmosphere;
-    FragColor = vec4(finalColor, 1.0);
-}
\ No newline at end of file
+    FragColor = vec4(lighting, 1.0);
+#endif
+}
@@ -0,0 +1,95 @@
+#version 430 core
+layout (local_size_x = 64) in;
+
+// Same layouts as IndirectRenderer
+struct DrawRecord
+{
+    mat4 model;
+    vec4 params;               // x = texture layer, y = flags
+    vec4 normalMatrix[3];      // columns, xyz (see TransformBatch)
+};
+
+struct Candidate
+{
+    vec4 bounds;               // xyz center, w radius
+    uint mesh;
+    uint passMask;
+    uint pad0;
+    uint pad1;
+};
+
+struct Command
+{
+    uint count;
+    uint instanceCount;
+    uint firstIndex;
+    int baseVertex;
+    uint baseInstance;
+};
+
+layout (std430, binding = 0) readonly buffer DrawRecords { DrawRecord draws[]; };
+layout (std430, binding = 1) readonly buffer Candidates { Candidate candidates[]; };
+layout (std430, binding = 2) buffer Commands { Command commands[]; };
+layout (std430, binding = 3) writeonly buffer VisibleDraws { uint visible[]; };
+
+const int MAX_OCCLUDERS = 16;
+const int SPHERE_SKY = 2;
+
+uniform int uCount;
+uniform int uPass;
+uniform int uFirstCommand;     // This pass's group of commands, one per mesh
+uniform vec4 uPlanes[6];       // xyz inward normal, w distance
+
+uniform vec3 uEye;
+uniform int uOccluderCount;
+uniform vec4 uOccluders[MAX_OCCLUDERS];      // xyz direction from the eye, w distance
+uniform float uOccluderAngles[MAX_OCCLUDERS]; // angular radius
+
+bool insideFrustum(vec4 sphere)
+{
+    for (int i = 0; i < 6; ++i)
+        if (dot(uPlanes[i].xyz, sphere.xyz) + uPlanes[i].w < -sphere.w)
+            return false;
+    return true;
+}
+
+// Same test as SphereOccluders::isOccluded
+bool occluded(vec4 sphere)
+{
+    vec3 toCenter = sphere.xyz - uEye;
+    float d = length(toCenter);
+    if (d <= sphere.w)
+        return false;
+
+    vec3 dir = toCenter / d;
+    float angle = asin(sphere.w / d);
+    for (int i = 0; i < uOccluderCount; ++i)
+    {
+        if (d - sphere.w < uOccluders[i].w)
+            continue;
+        float theta = acos(clamp(dot(dir, uOccluders[i].xyz), -1.0, 1.0));
+        if (theta + angle <= uOccluderAngles[i])
+            return true;
+    }
+    return false;
+}
+
+void main()
+{
+    uint id = gl_GlobalInvocationID.x;
+    if (id >= uint(uCount))
+        return;
+
+    Candidate c = candidates[id];
+    if ((c.passMask & (1u << uPass)) == 0u)
+        return;
+
+    // The sky surrounds the eye and is never occluded
+    bool sky = (int(draws[id].params.y) & SPHERE_SKY) != 0;
+    if (!sky && (!insideFrustum(c.bounds) || occluded(c.bounds)))
+        return;
+
+    uint command = uint(uFirstCommand) + c.mesh;
+    uint slot = atomicAdd(commands[command].instanceCount, 1u);
+    visible[commands[command].baseInstance + slot] = id;
+}
@@ -0,0 +1,33 @@
+#version 430 core
+#extension GL_ARB_shader_draw_parameters : require
+
+// Vertex position input
+layout (location = 0) in vec3 aPos;
+
+// One record per indirect draw (see IndirectRenderer)
+struct DrawRecord
+{
+    mat4 model;
+    vec4 params;               // x = texture layer, y = flags
+    vec4 normalMatrix[3];      // columns, xyz (see TransformBatch)
+};
+
+layout (std430, binding = 0) readonly buffer DrawRecords
+{
+    DrawRecord draws[];
+};
+
+// Records that survived indirect_cull.glsl, grouped by command
+layout (std430, binding = 3) readonly buffer VisibleDraws
+{
+    uint visible[];
+};
+
+// The Lighting block (light-space transform) comes from FrameUniforms::prelude()
+
+void main()
+{
+    // The cull shader never lists the sky for the shadow pass
+    DrawRecord draw = draws[visible[gl_BaseInstanceARB + gl_InstanceID]];
+    gl_Position = lightSpaceMatrix * draw.model * vec4(aPos, 1.0);
+}
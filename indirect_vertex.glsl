@@ -0,0 +1,54 @@
+#version 430 core
+#extension GL_ARB_shader_draw_parameters : require
+layout (location = 0) in vec3 aPos;
+layout (location = 1) in vec3 aNormal;
+layout (location = 2) in vec2 aTexCoords;
+
+out vec3 FragPos;              // Position of the fragment in world space
+out vec3 Normal;               // Normal for lighting
+out vec2 TexCoords;            // Texture coordinates
+out vec4 FragPosLightSpace;    // Position in light space for shadows
+flat out float Layer;          // Texture array layer
+flat out int Flags;            // SphereFlags
+
+// One record per indirect draw (see IndirectRenderer)
+struct DrawRecord
+{
+    mat4 model;
+    vec4 params;               // x = texture layer, y = flags
+    vec4 normalMatrix[3];      // columns, xyz (see TransformBatch)
+};
+
+layout (std430, binding = 0) readonly buffer DrawRecords
+{
+    DrawRecord draws[];
+};
+
+// Records that survived indirect_cull.glsl, grouped by command
+layout (std430, binding = 3) readonly buffer VisibleDraws
+{
+    uint visible[];
+};
+
+// Camera and Lighting blocks and SceneDepth() come from FrameUniforms::prelude()
+
+const int SPHERE_SKY = 2;
+
+void main()
+{
+    DrawRecord draw = draws[visible[gl_BaseInstanceARB + gl_InstanceID]];
+
+    FragPos = vec3(draw.model * vec4(aPos, 1.0));
+    Normal = mat3(draw.normalMatrix[0].xyz, draw.normalMatrix[1].xyz, draw.normalMatrix[2].xyz) * aNormal;
+    TexCoords = aTexCoords;
+    Layer = draw.params.x;
+    Flags = int(draw.params.y);
+
+    FragPosLightSpace = lightSpaceMatrix * vec4(FragPos, 1.0);
+
+    vec4 clipPos = projection * view * vec4(FragPos, 1.0);
+
+    // The sky sits exactly on the far plane so every body draws over it
+    gl_Position = ((Flags & SPHERE_SKY) != 0) ? vec4(clipPos.xy, depthParams.z * clipPos.w, clipPos.w)
+                                               : SceneDepth(clipPos);
+}
@@ -14,14 +14,32 @@
 #include <vector>
 #include <limits>
 #include <algorithm>
+#include <memory>
 
 #include "Shader.h"
+#include "ShaderPermutations.h"
 #include "Camera/Camera.h"
 #include "Texture.h"
 #include "SolarSystem.h"
 #include "Skybox.h"
 #include "AsteroidBelt.h"
 #include "Model.h"
+#include "CollisionWorld.h"
+#include "SphereMesh.h"
+#include "SphereBatch.h"
+#include "SpriteBatch.h"
+#include "StressField.h"
+#include "SphereBenchmark.h"
+#include "DynamicResolution.h"
+#include "FramePacer.h"
+#include "TextureArray.h"
+#include "PlanetTerrain.h"
+#include "FrameUniforms.h"
+#include "GLState.h"
+#include "RenderQueue.h"
+#include "IndirectRenderer.h"
+#include "RenderGraph.h"
+#include "StreamBuffer.h"
 
 // ====== stb_easy_font (public domain) ======
 #define STB_EASY_FONT_IMPLEMENTATION
@@ -33,6 +51,16 @@ const unsigned int SCR_HEIGHT = 720;
 
 const unsigned int SHADOW_WIDTH = 2048, SHADOW_HEIGHT = 2048;
 
+// Quadtree terrain replaces a body's sphere within this many radii of its surface
+const float TERRAIN_RANGE_RADII = 8.0f;
+
+// Surface shader permutations per kind of object
+const unsigned int LIT_SPHERE_FEATURES = SHADER_INSTANCED | SHADER_SHADOWS | SHADER_ATMOSPHERE; // planets, moons, terrain
+const unsigned int EMISSIVE_SPHERE_FEATURES = SHADER_INSTANCED | SHADER_EMISSIVE;              // the Sun, the sky
+const unsigned int MODEL_FEATURES = SHADER_SHADOWS;                                            // OBJ models
+const unsigned int LIT_IMPOSTOR_FEATURES = LIT_SPHERE_FEATURES | SHADER_IMPOSTOR;
+const unsigned int EMISSIVE_IMPOSTOR_FEATURES = EMISSIVE_SPHERE_FEATURES | SHADER_IMPOSTOR;
+
 Camera camera(glm::vec3(0.0f, 0.0f, 25.0f));
 
 float lastX = SCR_WIDTH / 2.0f;
@@ -42,14 +70,22 @@ bool cursorCaptured = true;
 float deltaTime = 0.0f;
 float lastFrame = 0.0f;
 
+// Render on demand: while paused and still, the loop sleeps until an input
+// callback asks for another frame (the timeout only re-checks the window)
+static bool gRedrawRequested = true;
+const double IDLE_WAIT_SECONDS = 0.5;
+
 static SolarSystem *gSolar = nullptr;
 
 // HUD globals
 static Shader *gHudShader = nullptr;
-static unsigned int gHudVAO = 0, gHudVBO = 0, gHudEBO = 0;
-static unsigned int gPanelVAO = 0, gPanelVBO = 0, gPanelEBO = 0;
+static Uniform<glm::mat4> gHudProjection;
+static unsigned int gHudVAO = 0;
+static StreamBuffer *gHudStream = nullptr;
 static float gHudAlpha = 0.0f;
 static double gHudShowTimer = 0.0;
+static bool gDebugHud = false;  // H: renderer diagnostics panel
+static std::string gDebugText; // rebuilt a few times a second while shown
 
 // Model globals
 static ObjModel gAcrimSAT;
@@ -63,13 +99,28 @@ static float gSatAngularSpeed = 0.8f;               // rad/sec (sim units)
 static float gSatOrbitRadius = 2.2f;                // distance from Earth's center (scene units)
 static float gSatInclination = glm::radians(28.0f); // tilt
 
+// Sphere path benchmark: impostors instead of meshes, plus a synthetic field of bodies
+static int gSpherePath = SPHERE_PATH_MESH;
+static bool gGpuDrivenAvailable = false; // IndirectRenderer::supported()
+static SphereBenchmark gBenchmark;
+static int gStressStep = 0; // StressField::stepSize
+
+// Scene render scale follows GPU frame time (see DynamicResolution)
+static DynamicResolution gDynamicResolution;
+
+// Frame limiter, vsync and low-latency input sampling (see FramePacer)
+static FramePacer gFramePacer;
+static const double FRAME_LIMITS[] = {0.0, 30.0, 60.0, 120.0};
+static int gFrameLimitIdx = 0;
+
 // Protos
 void framebuffer_size_callback(GLFWwindow *window, int width, int height);
 void mouse_callback(GLFWwindow *window, double xpos, double ypos);
 void mouse_button_callback(GLFWwindow *window, int button, int action, int mods);
 void scroll_callback(GLFWwindow *window, double xoffset, double yoffset);
+void key_callback(GLFWwindow *window, int key, int scancode, int action, int mods);
+void window_refresh_callback(GLFWwindow *window);
 void processInput(GLFWwindow *window, SolarSystem &solar);
-void generateSphere(unsigned int &VAO, unsigned int &VBO, int &vertexCount, int sectorCount = 36, int stackCount = 18);
 
 // HUD helpers
 struct HudVertex
@@ -81,6 +132,7 @@ static void hudEnsureBuffers();
 static void hudDrawString(GLFWwindow *window, Shader &hudShader, const std::string &text, float x, float y, float alpha);
 static void hudDrawPanel(GLFWwindow *window, Shader &hudShader, float x, float y, float w, float h, float alpha);
 static void hudRender(GLFWwindow *window, Shader &hudShader, const SolarSystem &solar, float dt);
+static void hudDrawDebug(GLFWwindow *window, Shader &hudShader);
 
 static void centerCameraOnSolarSystem()
 {
@@ -89,6 +141,19 @@ static void centerCameraOnSolarSystem()
     camera.Pitch = -10.0f;
 }
 
+// Fixed conditions for SphereBenchmark: frozen bodies, full resolution, no
+// frame limit or vsync; the loop holds the view and steps the configurations
+static void startBenchmark(SolarSystem &solar)
+{
+    solar.setPaused(true);
+    gDynamicResolution.setEnabled(false);
+    gFrameLimitIdx = 0;
+    gFramePacer.setTargetFps(0.0);
+    gFramePacer.setSwapInterval(0);
+    gBenchmark.start(gGpuDrivenAvailable);
+    std::cout << "Running the sphere path benchmark...\n";
+}
+
 static void updateWindowTitle(GLFWwindow *window, const SolarSystem &solar, const std::string &extra = "")
 {
     std::ostringstream ss;
@@ -136,40 +201,32 @@ static void hudEnsureBuffers()
     if (gHudVAO != 0)
         return;
 
+    // Vertices and indices are streamed per draw; the attribute pointers follow them
     glGenVertexArrays(1, &gHudVAO);
-    glGenBuffers(1, &gHudVBO);
-    glGenBuffers(1, &gHudEBO);
+    gHudStream = new StreamBuffer(64 * 1024);
 
     glBindVertexArray(gHudVAO);
-    glBindBuffer(GL_ARRAY_BUFFER, gHudVBO);
-    glBufferData(GL_ARRAY_BUFFER, 1, nullptr, GL_DYNAMIC_DRAW);
-
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, gHudEBO);
-    glBufferData(GL_ELEMENT_ARRAY_BUFFER, 1, nullptr, GL_DYNAMIC_DRAW);
-
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(HudVertex), (void *)0);
     glEnableVertexAttribArray(0);
-    glVertexAttribPointer(1, 4, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(HudVertex), (void *)(3 * sizeof(float)));
     glEnableVertexAttribArray(1);
     glBindVertexArray(0);
 
-    glGenVertexArrays(1, &gPanelVAO);
-    glGenBuffers(1, &gPanelVBO);
-    glGenBuffers(1, &gPanelEBO);
-
-    glBindVertexArray(gPanelVAO);
-    glBindBuffer(GL_ARRAY_BUFFER, gPanelVBO);
-    glBufferData(GL_ARRAY_BUFFER, 6 * sizeof(HudVertex), nullptr, GL_DYNAMIC_DRAW);
-
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, gPanelEBO);
-    unsigned int idx[6] = {0, 1, 2, 2, 3, 0};
-    glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(idx), idx, GL_STATIC_DRAW);
+    // Bound VAOs changed behind the state cache
+    GLState::invalidate();
+}
 
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(HudVertex), (void *)0);
-    glEnableVertexAttribArray(0);
-    glVertexAttribPointer(1, 4, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(HudVertex), (void *)(3 * sizeof(float)));
-    glEnableVertexAttribArray(1);
-    glBindVertexArray(0);
+// Stream one batch of HUD triangles and draw it; shader and blending must be set
+static void hudDrawQuads(const void *vertices, int vertexCount, const unsigned int *indices, int indexCount)
+{
+    gHudStream->reserve(vertexCount * sizeof(HudVertex) + indexCount * sizeof(unsigned int) + 32);
+    size_t vertexOffset = gHudStream->write(vertices, vertexCount * sizeof(HudVertex));
+    size_t indexOffset = gHudStream->write(indices, indexCount * sizeof(unsigned int));
+
+    GLState::bindVertexArray(gHudVAO);
+    glBindBuffer(GL_ARRAY_BUFFER, gHudStream->id());
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, gHudStream->id());
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(HudVertex), (void *)vertexOffset);
+    glVertexAttribPointer(1, 4, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(HudVertex), (void *)(vertexOffset + 3 * sizeof(float)));
+    glDrawElements(GL_TRIANGLES, indexCount, GL_UNSIGNED_INT, (void *)indexOffset);
 }
 
 static void hudDrawString(GLFWwindow *window, Shader &hudShader, const std::string &text, float x, float y, float alpha)
@@ -178,7 +235,7 @@ static void hudDrawString(GLFWwindow *window, Shader &hudShader, const std::stri
         return;
     hudEnsureBuffers();
 
-    const int MAX = 2048;
+    const int MAX = 8192; // quads; the debug panel runs to a few thousand
     static std::vector<unsigned char> raw;
     raw.resize(MAX * 4 * sizeof(HudVertex));
     unsigned char white[4] = {255, 255, 255, (unsigned char)std::clamp<int>(int(alpha * 255.0f), 0, 255)};
@@ -200,13 +257,6 @@ static void hudDrawString(GLFWwindow *window, Shader &hudShader, const std::stri
         indices[q * 6 + 5] = base + 3;
     }
 
-    glBindVertexArray(gHudVAO);
-    glBindBuffer(GL_ARRAY_BUFFER, gHudVBO);
-    glBufferData(GL_ARRAY_BUFFER, num_quads * 4 * sizeof(HudVertex), raw.data(), GL_DYNAMIC_DRAW);
-
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, gHudEBO);
-    glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(unsigned), indices.data(), GL_DYNAMIC_DRAW);
-
     int ww, wh;
     glfwGetWindowSize(window, &ww, &wh);
     if (ww <= 0 || wh <= 0)
@@ -217,13 +267,12 @@ static void hudDrawString(GLFWwindow *window, Shader &hudShader, const std::stri
     glm::mat4 ortho = glm::ortho(0.0f, (float)ww, (float)wh, 0.0f, -1.0f, 1.0f);
 
     hudShader.use();
-    hudShader.setMat4("uProjection", ortho);
+    hudShader.set(gHudProjection, ortho);
 
-    glEnable(GL_BLEND);
-    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
-    glDrawElements(GL_TRIANGLES, (GLsizei)indices.size(), GL_UNSIGNED_INT, 0);
-    glDisable(GL_BLEND);
-    glBindVertexArray(0);
+    // Blending stays on for the rest of the HUD; the frame loop turns it off
+    GLState::enable(GL_BLEND);
+    GLState::blendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    hudDrawQuads(raw.data(), num_quads * 4, indices.data(), (int)indices.size());
 }
 
 static void hudDrawPanel(GLFWwindow *window, Shader &hudShader, float x, float y, float w, float h, float alpha)
@@ -244,10 +293,7 @@ static void hudDrawPanel(GLFWwindow *window, Shader &hudShader, float x, float y
     setv(1, x + w, y);
     setv(2, x + w, y + h);
     setv(3, x, y + h);
-
-    glBindVertexArray(gPanelVAO);
-    glBindBuffer(GL_ARRAY_BUFFER, gPanelVBO);
-    glBufferSubData(GL_ARRAY_BUFFER, 0, 4 * sizeof(HudVertex), v);
+    const unsigned int idx[6] = {0, 1, 2, 2, 3, 0};
 
     int ww, wh;
     glfwGetWindowSize(window, &ww, &wh);
@@ -259,13 +305,11 @@ static void hudDrawPanel(GLFWwindow *window, Shader &hudShader, float x, float y
     glm::mat4 ortho = glm::ortho(0.0f, (float)ww, (float)wh, 0.0f, -1.0f, 1.0f);
 
     hudShader.use();
-    hudShader.setMat4("uProjection", ortho);
+    hudShader.set(gHudProjection, ortho);
 
-    glEnable(GL_BLEND);
-    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
-    glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, 0);
-    glDisable(GL_BLEND);
-    glBindVertexArray(0);
+    GLState::enable(GL_BLEND);
+    GLState::blendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    hudDrawQuads(v, 4, idx, 6);
 }
 
 static void hudRender(GLFWwindow *window, Shader &hudShader, const SolarSystem &solar, float dt)
@@ -326,6 +370,50 @@ static void hudRender(GLFWwindow *window, Shader &hudShader, const SolarSystem &
     hudDrawString(window, hudShader, wrapped, textX, textY, gHudAlpha);
 }
 
+// Top-right panel with gDebugText, independent of the fading fact panel
+static void hudDrawDebug(GLFWwindow *window, Shader &hudShader)
+{
+    if (!gDebugHud || gDebugText.empty())
+        return;
+
+    int ww, wh;
+    glfwGetWindowSize(window, &ww, &wh);
+    if (ww <= 0 || wh <= 0)
+    {
+        ww = SCR_WIDTH;
+        wh = SCR_HEIGHT;
+    }
+
+    int text_w = stb_easy_font_width((char *)gDebugText.c_str());
+    int lines = 1;
+    for (char c : gDebugText)
+        if (c == '\n')
+            ++lines;
+    int text_h = lines * 8;
+
+    float padX = 10.0f, padY = 10.0f;
+    float panelW = (float)text_w + padX * 2.0f;
+    float panelH = (float)text_h + padY * 2.0f;
+    float panelX = std::max(14.0f, (float)ww - panelW - 14.0f), panelY = 14.0f;
+
+    hudDrawPanel(window, hudShader, panelX, panelY, panelW, panelH, 1.0f);
+    hudDrawString(window, hudShader, gDebugText, panelX + padX, panelY + padY + 8.0f, 1.0f);
+}
+
+// Depth 1.0 everywhere: the shadow map bound when nothing casts, so every fragment is lit
+static GLuint createLitShadowMap1x1()
+{
+    GLuint tex;
+    glGenTextures(1, &tex);
+    glBindTexture(GL_TEXTURE_2D, tex);
+    float depth = 1.0f;
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_DEPTH_COMPONENT24, 1, 1, 0, GL_DEPTH_COMPONENT, GL_FLOAT, &depth);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glBindTexture(GL_TEXTURE_2D, 0);
+    return tex;
+}
+
 static GLuint createWhiteTexture1x1()
 {
     GLuint tex;
@@ -339,14 +427,33 @@ static GLuint createWhiteTexture1x1()
     return tex;
 }
 
-int main()
+int main(int argc, char **argv)
 {
+    // --benchmark: run the sphere path benchmark, print its table and exit
+    bool benchmarkMode = false;
+    for (int i = 1; i < argc; ++i)
+        if (std::string(argv[i]) == "--benchmark")
+            benchmarkMode = true;
+
     glfwInit();
-    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
-    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
-    glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
 
-    GLFWwindow *window = glfwCreateWindow(SCR_WIDTH, SCR_HEIGHT, "Interactive Solar System", NULL, NULL);
+    // Newest core context first: 4.5 enables indirect drawing (Mesa llvmpipe has it),
+    // 4.1 is the macOS ceiling, 3.3 is the baseline
+    const int contextVersions[][2] = {{4, 5}, {4, 1}, {3, 3}};
+    GLFWwindow *window = NULL;
+    for (const auto &version : contextVersions)
+    {
+        glfwDefaultWindowHints();
+        glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, version[0]);
+        glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, version[1]);
+        glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+#ifdef __APPLE__
+        glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE);
+#endif
+        window = glfwCreateWindow(SCR_WIDTH, SCR_HEIGHT, "Interactive Solar System", NULL, NULL);
+        if (window)
+            break;
+    }
     if (window == NULL)
     {
         std::cerr << "Failed to create GLFW window\n";
@@ -354,10 +461,13 @@ int main()
         return -1;
     }
     glfwMakeContextCurrent(window);
+    gFramePacer.setSwapInterval(1);
     glfwSetFramebufferSizeCallback(window, framebuffer_size_callback);
     glfwSetCursorPosCallback(window, mouse_callback);
     glfwSetMouseButtonCallback(window, mouse_button_callback);
     glfwSetScrollCallback(window, scroll_callback);
+    glfwSetKeyCallback(window, key_callback);
+    glfwSetWindowRefreshCallback(window, window_refresh_callback);
     glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
 
     glewExperimental = true;
@@ -369,22 +479,61 @@ int main()
 
     glEnable(GL_DEPTH_TEST);
 
-    // 3D Shaders
-    Shader shader("vertex.glsl", "fragment.glsl");
-    Shader shadowShader("shadow_vertex.glsl", "shadow_fragment.glsl");
-    Shader particleShader("particle_vertex.glsl", "particle_fragment.glsl");
-    Shader skyboxShader("skybox_vertex.glsl", "skybox_fragment.glsl");
+    // Reversed-Z into a float depth target keeps precision from the nearest
+    // moon to the skybox; without clip control the shaders write log depth
+    camera.depthMode = (GLEW_VERSION_4_5 || GLEW_ARB_clip_control) ? DEPTH_REVERSED : DEPTH_LOGARITHMIC;
+    if (camera.depthMode == DEPTH_LOGARITHMIC)
+        camera.farPlane = LOG_DEPTH_FAR_PLANE;
+
+    // Programs are only submitted here; the driver compiles them (on its own
+    // threads with parallel_shader_compile) while textures and models load,
+    // and finalize() below collects the results
+    Shader::enableParallelCompile();
+
+    // Camera and lighting live in shared uniform buffers, written once per frame
+    FrameUniforms frameUniforms;
+
+    // Block bindings and sampler units of every surface program; samplers a
+    // permutation does not use have no location and are ignored
+    auto surfaceSetup = [&frameUniforms](Shader &program)
+    {
+        frameUniforms.attach(program);
+        program.use();
+        program.setInt("textureLayers", 0);
+        program.setInt("texture_diffuse1", 0);
+        program.setInt("shadowMap", 1);
+    };
+
+    // 3D Shaders: one surface source, built per feature set as bodies need it.
+    // Every scene program gets the shared block declarations spliced in.
+    ShaderPermutations surfaceShaders("vertex.glsl", "fragment.glsl", surfaceSetup, FrameUniforms::prelude());
+    surfaceShaders.prepare(LIT_SPHERE_FEATURES);
+    surfaceShaders.prepare(EMISSIVE_SPHERE_FEATURES);
+    surfaceShaders.prepare(LIT_IMPOSTOR_FEATURES);
+    surfaceShaders.prepare(EMISSIVE_IMPOSTOR_FEATURES);
+    Shader shadowShader("shadow_vertex.glsl", "shadow_fragment.glsl", FrameUniforms::prelude());
+    Shader particleShader("particle_vertex.glsl", "particle_fragment.glsl", FrameUniforms::prelude());
+    Shader spriteShader("sprite_vertex.glsl", "sprite_fragment.glsl", FrameUniforms::prelude());
 
     // HUD shader
     Shader hudShader("hud_vertex.glsl", "hud_fragment.glsl");
     gHudShader = &hudShader;
 
+    // GPU-driven path programs (see the indirect renderer below)
+    std::unique_ptr<Shader> indirectShader, indirectShadowShader;
+    if (IndirectRenderer::supported())
+    {
+        // One multi-draw covers every body, so this is the lit permutation
+        indirectShader.reset(new Shader("indirect_vertex.glsl", "fragment.glsl",
+                                        ShaderPermutations::defines(LIT_SPHERE_FEATURES) + FrameUniforms::prelude()));
+        indirectShadowShader.reset(new Shader("indirect_shadow_vertex.glsl", "shadow_fragment.glsl",
+                                              FrameUniforms::prelude()));
+    }
+
     gWhiteTex = createWhiteTexture1x1();
 
-    // Sphere geometry
-    unsigned int sphereVAO, sphereVBO;
-    int vertexCount = 0;
-    generateSphere(sphereVAO, sphereVBO, vertexCount);
+    // Sphere geometry: indexed LOD chain shared by every body
+    SphereMesh sphereMesh;
 
     // Solar system
     SolarSystem solarSystem;
@@ -402,24 +551,23 @@ int main()
     Skybox skybox("assets/textures/stars.jpg");
     AsteroidBelt asteroidBelt(500, 12.0f, 15.0f);
 
-    // Depth map FBO
-    unsigned int depthMapFBO;
-    glGenFramebuffers(1, &depthMapFBO);
-    unsigned int depthMap;
-    glGenTextures(1, &depthMap);
-    glBindTexture(GL_TEXTURE_2D, depthMap);
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_DEPTH_COMPONENT, SHADOW_WIDTH, SHADOW_HEIGHT, 0, GL_DEPTH_COMPONENT, GL_FLOAT, NULL);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_BORDER);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_BORDER);
-    float borderColor[] = {1, 1, 1, 1};
-    glTexParameterfv(GL_TEXTURE_2D, GL_TEXTURE_BORDER_COLOR, borderColor);
-    glBindFramebuffer(GL_FRAMEBUFFER, depthMapFBO);
-    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, depthMap, 0);
-    glDrawBuffer(GL_NONE);
-    glReadBuffer(GL_NONE);
-    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    // All sphere textures in one array so every sphere goes out in one instanced draw
+    TextureArray sphereTextures(1024, 512);
+    solarSystem.registerTextures(sphereTextures);
+    skybox.registerTexture(sphereTextures);
+    sphereTextures.build();
+
+    SphereBatch sphereBatch;
+    sphereBatch.attach(sphereMesh);
+    SpriteBatch spriteBatch;
+    StressField stressField;
+    PlanetTerrain planetTerrain;
+    SphereOccluders occluders;
+    RenderQueue renderQueue;
+
+    // Frame passes and their targets (the shadow map is a graph transient)
+    RenderGraph renderGraph;
+    GLuint litShadowMap = createLitShadowMap1x1();
 
     // -------- Load your AcrimSAT model (OBJ) --------
     const char *satPath = "assets/models/acrimsat.obj";
@@ -434,6 +582,85 @@ int main()
         std::cout << "Could not load: " << satPath << " — continuing without it.\n";
         gShowSat = false;
     }
+    if (gAcrimSAT.isReady())
+        surfaceShaders.prepare(MODEL_FEATURES);
+
+    // GPU-driven path: every sphere LOD and the satellite in one arena, one
+    // multi-draw per pass with per-draw data in a storage buffer
+    std::unique_ptr<IndirectRenderer> indirectRenderer;
+    int sphereMeshIds[SphereMesh::LEVEL_COUNT] = {};
+    int satMeshId = -1;
+    if (IndirectRenderer::supported())
+    {
+        IndirectRenderer *indirect = new IndirectRenderer();
+        indirectRenderer.reset(indirect);
+        gGpuDrivenAvailable = true;
+        gSpherePath = SPHERE_PATH_GPU_DRIVEN;
+        std::vector<unsigned int> levelIndices;
+        for (int l = 0; l < SphereMesh::LEVEL_COUNT; ++l)
+        {
+            const SphereMesh::Level &level = sphereMesh.level(l);
+            const unsigned short *first = sphereMesh.indexData().data() + level.firstIndexBytes / sizeof(unsigned short);
+            levelIndices.assign(first, first + level.indexCount);
+            sphereMeshIds[l] = indirect->addMesh(sphereMesh.vertexData().data() + level.baseVertex * 8,
+                                                 (size_t)(level.stacks + 1) * (level.sectors + 1),
+                                                 levelIndices.data(), levelIndices.size());
+        }
+        if (gAcrimSAT.isReady())
+            satMeshId = indirect->addMesh(gAcrimSAT.vertexData(), gAcrimSAT.vertexCount(),
+                                          gAcrimSAT.indices().data(), gAcrimSAT.indices().size());
+        indirect->finalize();
+    }
+
+    // Everything has loaded; collect the programs and do the one-time setup
+    std::vector<Shader *> programs = {&shadowShader, &particleShader, &spriteShader, &hudShader};
+    if (indirectShader)
+    {
+        programs.push_back(indirectShader.get());
+        programs.push_back(indirectShadowShader.get());
+    }
+    for (Shader *program : programs)
+    {
+        program->finalize();
+        frameUniforms.attach(*program);
+    }
+    gHudProjection = hudShader.uniform<glm::mat4>("uProjection");
+    if (indirectShader)
+        surfaceSetup(*indirectShader);
+    surfaceSetup(spriteShader);
+    Uniform<float> spritePixelScale = spriteShader.uniform<float>("pixelScale");
+
+    // Sphere permutations are needed from the first frame; others build on first use
+    surfaceShaders.get(LIT_SPHERE_FEATURES);
+    surfaceShaders.get(EMISSIVE_SPHERE_FEATURES);
+
+    // The satellite's per-object uniforms, resolved once like the HUD's
+    Shader *modelShader = nullptr;
+    Uniform<glm::mat4> objModel;
+    Uniform<glm::mat3> objNormal;
+    if (gAcrimSAT.isReady())
+    {
+        modelShader = &surfaceShaders.get(MODEL_FEATURES);
+        objModel = modelShader->uniform<glm::mat4>("model");
+        objNormal = modelShader->uniform<glm::mat3>("normalMatrix");
+    }
+
+    particleShader.use();
+    particleShader.setMat4("model", glm::mat4(1.0f));
+
+    std::cout << "OpenGL " << glGetString(GL_VERSION) << ", "
+              << (indirectRenderer ? "indirect multi-draw" : "instanced") << " submission\n";
+
+    // Collision proxies: the belt is static, bodies and the satellite move every step
+    CollisionWorld collisionWorld;
+    for (const glm::vec3 &p : asteroidBelt.getPositions())
+        collisionWorld.addProxy(p, asteroidBelt.particleRadius(), COLLIDE_ASTEROID, COLLIDE_BODY | COLLIDE_SATELLITE);
+    const std::vector<CelestialBody *> &bodies = solarSystem.bodies();
+    int firstBodyProxy = collisionWorld.proxyCount();
+    for (CelestialBody *body : bodies)
+        collisionWorld.addProxy(body->getPosition(), body->getRadius(), COLLIDE_BODY,
+                                COLLIDE_ASTEROID | COLLIDE_BODY | COLLIDE_SATELLITE);
+    int satProxy = collisionWorld.addProxy(glm::vec3(0.0f), 0.0f, COLLIDE_SATELLITE, COLLIDE_ASTEROID | COLLIDE_BODY);
 
     std::cout << "Controls:\n"
               << "  WASD / Space / Ctrl : Move camera\n"
@@ -445,69 +672,125 @@ int main()
               << "  F                   : Focus camera on selected\n"
               << "  T                   : Toggle camera tracking\n"
               << "  M                   : Toggle satellite visibility\n"
+              << "  I                   : Cycle sphere path (meshes / GPU-driven / impostors)\n"
+              << "  N                   : Run the sphere path benchmark (table on stdout)\n"
+              << "  B                   : Cycle benchmark bodies (0 / 1k / 10k / 100k)\n"
+              << "  V                   : Toggle dynamic resolution\n"
+              << "  K                   : Cycle frame limit (off / 30 / 60 / 120)\n"
+              << "  Y                   : Toggle vsync\n"
+              << "  L                   : Toggle low-latency input\n"
+              << "  H                   : Toggle debug HUD\n"
               << "  Tab                 : Toggle mouse capture\n"
               << "  R                   : Reset camera\n";
 
+    if (benchmarkMode)
+        startBenchmark(solarSystem);
+
     double titleTimer = 0.0;
+    glm::vec3 stillPosition = camera.Position, stillFront = camera.Front; // last frame's view, for idle detection
+    float stillZoom = camera.Zoom;
+
+    // Setup bound textures, VAOs and framebuffers directly
+    GLState::invalidate();
 
     while (!glfwWindowShouldClose(window))
     {
+        // In low-latency mode the limiter waits here rather than after the
+        // swap, so events and input are read just before they are rendered
+        gFramePacer.beginFrame();
+        if (gFramePacer.lowLatency())
+            glfwPollEvents();
+
         float currentFrame = glfwGetTime();
         deltaTime = currentFrame - lastFrame;
         lastFrame = currentFrame;
 
         processInput(window, solarSystem);
+        if (gBenchmark.running())
+        {
+            // Same view, sizes and paths on every run
+            camera.ResetPosition();
+            gStressStep = gBenchmark.stressStep();
+            gSpherePath = gBenchmark.path();
+        }
         camera.UpdateTracking(deltaTime);
 
-        // 1) Shadow pass (spheres only for simplicity)
+        // Advance the simulation first so both passes see the same transforms
+        solarSystem.update(deltaTime);
+
+        int fbw, fbh;
+        glfwGetFramebufferSize(window, &fbw, &fbh);
+
+        // The scene may render below window resolution; LOD and sprites follow its pixels
+        int sceneWidth, sceneHeight;
+        gDynamicResolution.targetSize(fbw, fbh, sceneWidth, sceneHeight);
+        float pixelScale = camera.getPixelScale(sceneHeight);
+
+        // Impostors are drawn by the instanced path; the GPU-driven one stays meshes only
+        bool impostors = gSpherePath == SPHERE_PATH_IMPOSTOR;
+        IndirectRenderer *indirect = gSpherePath == SPHERE_PATH_GPU_DRIVEN ? indirectRenderer.get() : nullptr;
+        sphereBatch.setImpostors(impostors);
+        if (stressField.size() != StressField::stepSize(gStressStep))
+            stressField.resize(StressField::stepSize(gStressStep), sphereTextures.layerCount());
+
+        // Close to a body its sphere gives way to the quadtree terrain
+        int nearBody = -1;
+        float clearance = solarSystem.nearestSurfaceDistance(camera.Position, &nearBody);
+        const CelestialBody *terrainBody = nullptr;
+        if (nearBody >= 0 && clearance < TERRAIN_RANGE_RADII * bodies[nearBody]->getRadius())
+            terrainBody = bodies[nearBody];
+        if (terrainBody)
+            planetTerrain.update(*terrainBody, camera.Position, pixelScale);
+
+        // One instance per sphere, mesh detail picked from its size on screen
+        sphereBatch.clear();
+        spriteBatch.clear();
+        solarSystem.appendInstances(sphereBatch, spriteBatch, camera.Position, pixelScale, terrainBody);
+        stressField.append(sphereBatch, camera.Position, pixelScale);
+        skybox.appendInstance(sphereBatch, camera.Position);
+
         glm::mat4 lightProjection = glm::ortho(-20.0f, 20.0f, -20.0f, 20.0f, 1.0f, 50.0f);
         glm::mat4 lightView = glm::lookAt(glm::vec3(10.0f, 20.0f, 10.0f), glm::vec3(0.0f), glm::vec3(0, 1, 0));
         glm::mat4 lightSpaceMatrix = lightProjection * lightView;
 
-        shadowShader.use();
-        shadowShader.setMat4("lightSpaceMatrix", lightSpaceMatrix);
-
-        glViewport(0, 0, SHADOW_WIDTH, SHADOW_HEIGHT);
-        glBindFramebuffer(GL_FRAMEBUFFER, depthMapFBO);
-        glClear(GL_DEPTH_BUFFER_BIT);
-        solarSystem.render(shadowShader, sphereVAO, vertexCount, camera.Position);
-        glBindFramebuffer(GL_FRAMEBUFFER, 0);
-
-        // 2) Scene pass
-        int fbw, fbh;
-        glfwGetFramebufferSize(window, &fbw, &fbh);
         camera.setAspectRatio((float)fbw / (float)fbh);
-        glViewport(0, 0, fbw, fbh);
-        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-
-        shader.use();
         glm::mat4 projection = camera.getProjectionMatrix();
         glm::mat4 view = camera.GetViewMatrix();
-        shader.setMat4("projection", projection);
-        shader.setMat4("view", view);
-        shader.setMat4("lightSpaceMatrix", lightSpaceMatrix);
-        shader.setInt("shadowMap", 1);
 
-        glm::vec3 lightPos = glm::vec3(10.0f, 20.0f, 10.0f);
-        shader.setVec3("lightPos", lightPos);
-        shader.setVec3("viewPos", camera.Position);
-        shader.setVec3("atmosphereColor", glm::vec3(0.4f, 0.6f, 1.0f));
-        shader.setFloat("atmosphereIntensity", 0.5f);
-
-        glActiveTexture(GL_TEXTURE1);
-        glBindTexture(GL_TEXTURE_2D, depthMap);
+        // Each pass only draws what its own frustum can see
+        Frustum lightFrustum = Frustum::fromMatrix(lightSpaceMatrix);
+        Frustum cameraFrustum = Frustum::fromMatrix(projection * view);
+        // Moons (and the satellite below) behind a planet or the Sun skip the main pass
+        solarSystem.collectOccluders(occluders, camera.Position);
+        spriteBatch.cull(cameraFrustum, &occluders);
+        if (!indirect)
+        {
+            sphereBatch.cull(SPHERE_PASS_SHADOW, lightFrustum);
+            sphereBatch.cull(SPHERE_PASS_MAIN, cameraFrustum, &occluders);
+            sphereBatch.sortFrontToBack(SPHERE_PASS_MAIN, camera.Position);
+            sphereBatch.upload();
+        }
 
-        glDepthFunc(GL_LEQUAL);
-        skybox.render(skyboxShader, sphereVAO, vertexCount, camera.Position); // <-- no copy
-        glDepthFunc(GL_LESS);
+        bool terrainShadow = false, terrainVisible = false;
+        if (terrainBody)
+        {
+            float terrainRadius = solarSystem.transforms().scale(nearBody);
+            terrainShadow = lightFrustum.intersectsSphere(terrainBody->getPosition(), terrainRadius);
+            terrainVisible = cameraFrustum.intersectsSphere(terrainBody->getPosition(), terrainRadius);
+        }
 
-        solarSystem.update(deltaTime);
-        solarSystem.render(shader, sphereVAO, vertexCount, camera.Position);
+        // The Sun is the light source for shading
+        glm::vec3 lightPos = solarSystem.getSunPosition();
+        frameUniforms.setCamera(projection, view, camera.Position, camera.getDepthParams());
+        frameUniforms.setLighting(lightSpaceMatrix, lightPos, glm::vec3(0.4f, 0.6f, 1.0f), 0.5f);
 
         // ===== Update satellite orbit around Earth =====
+        bool satActive = false, satVisible = false;
+        glm::mat4 satModel(1.0f);
         if (gShowSat && gAcrimSAT.isReady() && gEarthIdx >= 0)
         {
-            gSatAngle += gSatAngularSpeed * deltaTime;
+            if (!solarSystem.isPaused())
+                gSatAngle += gSatAngularSpeed * deltaTime;
 
             glm::vec3 earthPos = solarSystem.planetPosition(gEarthIdx);
             glm::vec3 orbitX = glm::vec3(1, 0, 0);
@@ -519,62 +802,375 @@ int main()
             gAcrimSAT.setPosition(satPos);
             gAcrimSAT.setRotationEuler(glm::vec3(0.0f, gSatAngle, 0.0f));
 
-            // Ensure a valid texture is bound for the material sampler
-            glActiveTexture(GL_TEXTURE0);
-            glBindTexture(GL_TEXTURE_2D, gWhiteTex);
-            shader.setInt("texture1", 0);
+            satModel = gAcrimSAT.modelMatrix();
+            satActive = true;
+            glm::vec3 satCenter = glm::vec3(satModel[3]);
+            float satRadius = gAcrimSAT.boundingRadius();
+            satVisible = cameraFrustum.intersectsSphere(satCenter, satRadius) && !occluders.isOccluded(satCenter, satRadius);
+        }
+
+        // Everything below is queued as draw packets, sorted by state then depth
+        renderQueue.clear();
+        GLuint shadowTexture = litShadowMap; // decided once the render graph is compiled
 
-            glm::mat4 model = gAcrimSAT.modelMatrix();
-            shader.setMat4("model", model);
-            gAcrimSAT.draw();
+        // Indirect path: every sphere and the satellite are candidates, culled on the GPU
+        int shadowCandidates = 0;
+        if (indirect)
+        {
+            indirect->clear();
+            for (int i = 0; i < sphereBatch.size(); ++i)
+            {
+                // The sky and the Sun cast no shadow, and sprite bodies cast only a shadow
+                unsigned int flags = (unsigned int)sphereBatch.instance(i).params.y;
+                unsigned int passMask = (1u << SPHERE_PASS_SHADOW) | (1u << SPHERE_PASS_MAIN);
+                if (flags & (SPHERE_SKY | SPHERE_EMISSIVE))
+                    passMask &= ~(1u << SPHERE_PASS_SHADOW);
+                if (flags & SPHERE_SHADOW_ONLY)
+                    passMask &= ~(1u << SPHERE_PASS_MAIN);
+                if (passMask == 0)
+                    continue;
+                if (passMask & (1u << SPHERE_PASS_SHADOW))
+                    ++shadowCandidates;
+                indirect->add(sphereMeshIds[sphereBatch.lod(i)], sphereBatch.instance(i), sphereBatch.bounds(i), passMask);
+            }
+            if (satActive && satMeshId >= 0)
+                indirect->add(satMeshId, SphereInstance{satModel, glm::vec4(0.0f, (float)SPHERE_UNTEXTURED, 0.0f, 0.0f),
+                                                        NormalMatrix::fromModel(satModel)},
+                              glm::vec4(glm::vec3(satModel[3]), gAcrimSAT.boundingRadius()), 1u << SPHERE_PASS_MAIN);
+            indirect->upload();
+            indirect->cull(SPHERE_PASS_SHADOW, lightFrustum);
+            indirect->cull(SPHERE_PASS_MAIN, cameraFrustum, &occluders);
+        }
+
+        // 1) Shadow pass (spheres only for simplicity)
+        renderQueue.setPassHooks(RENDER_PASS_SHADOW, [&]()
+        {
+            GLState::viewport(0, 0, SHADOW_WIDTH, SHADOW_HEIGHT);
+            glClear(GL_DEPTH_BUFFER_BIT);
+        });
+
+        DrawPacket shadowPacket;
+        shadowPacket.pass = RENDER_PASS_SHADOW;
+        shadowPacket.shader = &shadowShader;
+        if (indirect)
+        {
+            DrawPacket indirectPacket = shadowPacket;
+            indirectPacket.shader = indirectShadowShader.get();
+            indirectPacket.draw = [&]() { indirect->draw(SPHERE_PASS_SHADOW); };
+            renderQueue.submit(indirectPacket);
+        }
+        else
+            sphereBatch.submit(renderQueue, SPHERE_PASS_SHADOW, shadowPacket, camera.farPlane);
+        if (terrainShadow)
+        {
+            shadowPacket.draw = [&planetTerrain]() { planetTerrain.draw(); };
+            renderQueue.submit(shadowPacket);
+        }
+
+        // 2) Scene pass; the comparison includes equality because the sky is
+        // drawn at exactly the far plane. Reversed-Z only applies here, the
+        // shadow map keeps the standard convention.
+        bool reversedDepth = camera.depthMode == DEPTH_REVERSED;
+        renderQueue.setPassHooks(RENDER_PASS_OPAQUE, [&, reversedDepth]()
+        {
+            GLState::viewport(0, 0, sceneWidth, sceneHeight);
+            if (reversedDepth)
+            {
+                glClipControl(GL_LOWER_LEFT, GL_ZERO_TO_ONE);
+                glClearDepth(0.0);
+            }
+            glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+            GLState::activeTexture(GL_TEXTURE1);
+            GLState::bindTexture(GL_TEXTURE_2D, shadowTexture);
+            GLState::depthFunc(reversedDepth ? GL_GEQUAL : GL_LEQUAL);
+        });
+
+        DrawPacket spherePacket;
+        spherePacket.pass = RENDER_PASS_OPAQUE;
+        spherePacket.shader = &surfaceShaders.get(impostors ? LIT_IMPOSTOR_FEATURES : LIT_SPHERE_FEATURES);
+        spherePacket.textureTarget = GL_TEXTURE_2D_ARRAY;
+        spherePacket.texture = sphereTextures.ID;
+        if (indirect)
+        {
+            DrawPacket indirectPacket = spherePacket;
+            indirectPacket.shader = indirectShader.get();
+            indirectPacket.draw = [&]() { indirect->draw(SPHERE_PASS_MAIN); };
+            renderQueue.submit(indirectPacket);
+        }
+        else
+            sphereBatch.submit(renderQueue, SPHERE_PASS_MAIN, spherePacket, camera.farPlane,
+                               &surfaceShaders.get(impostors ? EMISSIVE_IMPOSTOR_FEATURES : EMISSIVE_SPHERE_FEATURES));
+        if (terrainVisible)
+        {
+            DrawPacket terrainPacket = spherePacket;
+            terrainPacket.shader = &surfaceShaders.get(LIT_SPHERE_FEATURES);
+            terrainPacket.depth = std::max(clearance, 0.0f) / camera.farPlane;
+            terrainPacket.draw = [&planetTerrain]() { planetTerrain.draw(); };
+            renderQueue.submit(terrainPacket);
+        }
+
+        // OBJ models use the per-object permutation unless they went out indirectly
+        if (satVisible && !indirect && modelShader)
+        {
+            glm::mat3 satNormal = NormalMatrix::fromModel(satModel).toMat3();
+            DrawPacket satPacket;
+            satPacket.shader = modelShader;
+            satPacket.texture = gWhiteTex; // a valid texture for the material sampler
+            satPacket.depth = glm::length(glm::vec3(satModel[3]) - camera.Position) / camera.farPlane;
+            satPacket.draw = [modelShader, objModel, objNormal, satModel, satNormal]()
+            {
+                modelShader->set(objModel, satModel);
+                modelShader->set(objNormal, satNormal);
+                gAcrimSAT.draw();
+            };
+            renderQueue.submit(satPacket);
         }
 
         // Asteroids
-        particleShader.use();
-        particleShader.setMat4("projection", projection);
-        particleShader.setMat4("view", view);
-        particleShader.setMat4("model", glm::mat4(1.0f));
-        asteroidBelt.render(particleShader);
+        DrawPacket beltPacket;
+        beltPacket.shader = &particleShader;
+        beltPacket.draw = [&asteroidBelt, &particleShader]() { asteroidBelt.render(particleShader); };
+        renderQueue.submit(beltPacket);
+
+        // Sub-pixel bodies add their light on top of the opaque scene; the
+        // scene's depth state (and clip control) is restored after them
+        renderQueue.setPassHooks(RENDER_PASS_BLENDED, []()
+        {
+            GLState::enable(GL_BLEND);
+            GLState::blendFunc(GL_ONE, GL_ONE);
+            GLState::enable(GL_PROGRAM_POINT_SIZE);
+            glDepthMask(GL_FALSE);
+        }, [reversedDepth]()
+        {
+            glDepthMask(GL_TRUE);
+            GLState::disable(GL_PROGRAM_POINT_SIZE);
+            GLState::disable(GL_BLEND);
+            if (reversedDepth)
+            {
+                glClipControl(GL_LOWER_LEFT, GL_NEGATIVE_ONE_TO_ONE);
+                glClearDepth(1.0);
+            }
+            GLState::depthFunc(GL_LESS);
+        });
+
+        DrawPacket spritePacket;
+        spritePacket.shader = &spriteShader;
+        spritePacket.textureTarget = GL_TEXTURE_2D_ARRAY;
+        spritePacket.texture = sphereTextures.ID;
+        spriteShader.use();
+        spriteShader.set(spritePixelScale, pixelScale);
+        spriteBatch.submit(renderQueue, spritePacket);
+
+        // HUD overlay, always at window resolution
+        renderQueue.setPassHooks(RENDER_PASS_OVERLAY, [&]()
+        {
+            GLState::viewport(0, 0, fbw, fbh);
+            GLState::disable(GL_DEPTH_TEST);
+        }, []()
+        {
+            GLState::disable(GL_BLEND);
+            GLState::enable(GL_DEPTH_TEST);
+        });
+
+        DrawPacket hudPacket;
+        hudPacket.pass = RENDER_PASS_OVERLAY;
+        hudPacket.shader = &hudShader;
+        hudPacket.draw = [&]()
+        {
+            hudRender(window, hudShader, solarSystem, deltaTime);
+            hudDrawDebug(window, hudShader);
+        };
+        renderQueue.submit(hudPacket);
+
+        // The graph orders the passes and drops the shadow pass when nothing
+        // casts, or nothing lit is on screen to receive it. The GPU-culled
+        // path only knows which candidates may cast, and assumes a receiver.
+        bool shadowCasters = terrainShadow || (indirect ? shadowCandidates > 0
+                                                        : sphereBatch.visibleCount(SPHERE_PASS_SHADOW) > 0);
+        bool shadowReceivers = indirect || terrainVisible || satVisible ||
+                               sphereBatch.litCount(SPHERE_PASS_MAIN) > 0;
+        bool shadowsNeeded = shadowCasters && shadowReceivers;
+        RenderTargetDesc shadowDesc;
+        shadowDesc.width = SHADOW_WIDTH;
+        shadowDesc.height = SHADOW_HEIGHT;
+        shadowDesc.internalFormat = GL_DEPTH_COMPONENT24;
+
+        // The scene renders offscreen so it gets a 32-bit float depth buffer
+        // whatever the default framebuffer has and can run at a lower
+        // resolution, then is stretched to the window
+        RenderTargetDesc sceneColorDesc;
+        sceneColorDesc.width = sceneWidth;
+        sceneColorDesc.height = sceneHeight;
+        RenderTargetDesc sceneDepthDesc = sceneColorDesc;
+        sceneDepthDesc.internalFormat = GL_DEPTH_COMPONENT32F;
+
+        renderGraph.reset();
+        RenderGraph::Resource backbuffer = renderGraph.importBackbuffer();
+        RenderGraph::Resource shadowMap = renderGraph.createTexture("shadow map", shadowDesc);
+        RenderGraph::Resource sceneColor = renderGraph.createTexture("scene color", sceneColorDesc);
+        RenderGraph::Resource sceneDepth = renderGraph.createTexture("scene depth", sceneDepthDesc);
+        int shadowPass = renderGraph.addPass("shadow", [&]() { renderQueue.executePass(RENDER_PASS_SHADOW); });
+        renderGraph.write(shadowPass, shadowMap);
+        int scenePass = renderGraph.addPass("scene", [&]()
+        {
+            renderQueue.executePass(RENDER_PASS_OPAQUE);
+            renderQueue.executePass(RENDER_PASS_BLENDED);
+        });
+        if (shadowsNeeded)
+            renderGraph.read(scenePass, shadowMap);
+        renderGraph.write(scenePass, sceneColor);
+        renderGraph.write(scenePass, sceneDepth);
+        int presentPass = renderGraph.addPass("present", [&]()
+        {
+            glBindFramebuffer(GL_READ_FRAMEBUFFER, renderGraph.framebuffer(scenePass));
+            glBlitFramebuffer(0, 0, sceneWidth, sceneHeight, 0, 0, fbw, fbh, GL_COLOR_BUFFER_BIT, GL_LINEAR);
+            glBindFramebuffer(GL_READ_FRAMEBUFFER, 0);
+        });
+        renderGraph.read(presentPass, sceneColor);
+        renderGraph.write(presentPass, backbuffer);
+        int hudPass = renderGraph.addPass("hud", [&]() { renderQueue.executePass(RENDER_PASS_OVERLAY); });
+        renderGraph.write(hudPass, backbuffer);
+        renderGraph.compile();
+
+        shadowTexture = shadowsNeeded ? renderGraph.texture(shadowMap) : litShadowMap;
+        renderQueue.prepare();
+        renderGraph.execute();
+
+        // Whole-frame GPU time (as far as the queries have arrived) sets the next scene size
+        float gpuMs = -1.0f;
+        for (const RenderGraph::PassTiming &timing : renderGraph.timings())
+            if (!timing.culled && timing.ms >= 0.0f)
+                gpuMs = std::max(gpuMs, 0.0f) + timing.ms;
+        gDynamicResolution.update(gpuMs);
+
+        if (gBenchmark.running())
+        {
+            for (const RenderGraph::PassTiming &timing : renderGraph.timings())
+                if (timing.name == "scene")
+                    gBenchmark.addFrame(timing.culled ? -1.0f : timing.ms);
+            if (gBenchmark.justFinished())
+            {
+                gBenchmark.printTable(std::cout);
+                if (benchmarkMode)
+                    glfwSetWindowShouldClose(window, true);
+            }
+        }
 
-        // HUD overlay
-        glDisable(GL_DEPTH_TEST);
-        hudRender(window, hudShader, solarSystem, deltaTime);
-        glEnable(GL_DEPTH_TEST);
+        // Collisions for this step
+        for (int i = 0; i < (int)bodies.size(); ++i)
+            collisionWorld.setProxy(firstBodyProxy + i, bodies[i]->getPosition());
+        if (gShowSat && gAcrimSAT.isReady())
+            collisionWorld.setProxy(satProxy, glm::vec3(gAcrimSAT.modelMatrix()[3]), gAcrimSAT.boundingRadius());
+        else
+            collisionWorld.setProxy(satProxy, glm::vec3(0.0f), 0.0f); // disabled while hidden
+        collisionWorld.step();
 
         titleTimer += deltaTime;
         if (titleTimer > 0.2)
         {
             updateWindowTitle(window, solarSystem);
+            if (gDebugHud)
+            {
+                std::ostringstream debug;
+                debug.setf(std::ios::fixed);
+                debug.precision(2);
+                const FramePacer::Stats &frameStats = gFramePacer.stats();
+                debug << "Frame: " << frameStats.meanMs << " ms, jitter " << frameStats.jitterMs << " ms ("
+                      << frameStats.minMs << "-" << frameStats.maxMs << "), limit ";
+                if (gFramePacer.targetFps() > 0.0)
+                    debug << gFramePacer.targetFps();
+                else
+                    debug << "off";
+                debug << ", vsync " << (gFramePacer.swapInterval() != 0 ? "on" : "off")
+                      << (gFramePacer.lowLatency() ? ", low latency" : "") << "\n";
+                debug << "GPU:";
+                for (const RenderGraph::PassTiming &timing : renderGraph.timings())
+                {
+                    debug << " " << timing.name;
+                    if (timing.culled)
+                        debug << " culled";
+                    else if (timing.ms >= 0.0f)
+                        debug << " " << timing.ms << " ms";
+                }
+                debug << "\n";
+                debug << "Scene: " << sceneWidth << "x" << sceneHeight
+                      << (gDynamicResolution.enabled() ? " (dynamic)" : "") << "\n";
+                debug << "Spheres: " << spherePathName(gSpherePath);
+                if (stressField.size() > 0)
+                    debug << " + " << stressField.size() << " benchmark";
+                debug << "\n";
+                // GPU culling results stay on the GPU; only the candidate count is known here
+                if (indirect)
+                    debug << "GPU-culled: " << indirect->candidateCount() << " candidates\n";
+                else
+                    debug << "Visible: " << sphereBatch.visibleCount(SPHERE_PASS_MAIN) << " ("
+                          << sphereBatch.culledCount(SPHERE_PASS_MAIN) << " culled, "
+                          << sphereBatch.occludedCount(SPHERE_PASS_MAIN) << " occluded), shadow "
+                          << sphereBatch.visibleCount(SPHERE_PASS_SHADOW) << " ("
+                          << sphereBatch.culledCount(SPHERE_PASS_SHADOW) << " culled)\n";
+                debug << "Sprites: " << spriteBatch.visibleCount() << " of " << spriteBatch.size() << "\n";
+                if (terrainBody)
+                    debug << "Terrain: " << planetTerrain.chunksDrawn() << " chunks (" << planetTerrain.chunksCached()
+                          << " cached, " << planetTerrain.chunksPending() << " pending)\n";
+                debug << "Packets: " << renderQueue.packetCount() << " (" << renderQueue.programSwitches()
+                      << " program, " << renderQueue.textureSwitches() << " texture switches)\n";
+                debug << "GL state: " << GLState::issuedCalls() << " issued, " << GLState::skippedCalls() << " skipped\n";
+                debug << "Contacts: " << collisionWorld.contacts().size() << " (" << collisionWorld.lastStepMs() << " ms)";
+                gDebugText = debug.str();
+            }
             titleTimer = 0.0;
         }
 
+        GLState::endFrame();
+        StreamBuffer::endFrame();
         glfwSwapBuffers(window);
-        glfwPollEvents();
+        gFramePacer.endFrame();
+
+        // Nothing on screen can change without an event: the simulation is
+        // paused, the camera is where it was last frame, the HUD has faded
+        // and no terrain is still building. Sleep instead of redrawing (not
+        // while the debug HUD shows live numbers).
+        bool cameraStill = camera.Position == stillPosition && camera.Front == stillFront && camera.Zoom == stillZoom;
+        bool hudSettled = gHudShowTimer >= 4.0 && gHudAlpha <= 0.01f;
+        bool still = solarSystem.isPaused() && !gRedrawRequested && cameraStill && hudSettled &&
+                     planetTerrain.chunksPending() == 0 && !gBenchmark.running() && !gDebugHud;
+        stillPosition = camera.Position;
+        stillFront = camera.Front;
+        stillZoom = camera.Zoom;
+        gRedrawRequested = false;
+        if (still)
+        {
+            while (!gRedrawRequested && !glfwWindowShouldClose(window))
+                glfwWaitEventsTimeout(IDLE_WAIT_SECONDS);
+            lastFrame = (float)glfwGetTime(); // the wait is not frame time
+            gFramePacer.resetClock();
+        }
+        else if (!gFramePacer.lowLatency())
+            glfwPollEvents();
     }
 
-    glDeleteVertexArrays(1, &sphereVAO);
-    glDeleteBuffers(1, &sphereVBO);
     if (gWhiteTex)
         glDeleteTextures(1, &gWhiteTex);
+    glDeleteTextures(1, &litShadowMap);
 
     if (gHudVAO)
         glDeleteVertexArrays(1, &gHudVAO);
-    if (gHudVBO)
-        glDeleteBuffers(1, &gHudVBO);
-    if (gHudEBO)
-        glDeleteBuffers(1, &gHudEBO);
-    if (gPanelVAO)
-        glDeleteVertexArrays(1, &gPanelVAO);
-    if (gPanelVBO)
-        glDeleteBuffers(1, &gPanelVBO);
-    if (gPanelEBO)
-        glDeleteBuffers(1, &gPanelEBO);
+    delete gHudStream;
 
     glfwTerminate();
     return 0;
 }
 
-void framebuffer_size_callback(GLFWwindow *window, int width, int height) { glViewport(0, 0, width, height); }
+void framebuffer_size_callback(GLFWwindow *window, int width, int height)
+{
+    GLState::viewport(0, 0, width, height);
+    gRedrawRequested = true;
+}
+
+void window_refresh_callback(GLFWwindow *) { gRedrawRequested = true; }
+
+// Keys are polled in processInput; this only wakes an idle loop
+void key_callback(GLFWwindow *, int, int, int, int) { gRedrawRequested = true; }
 
 void mouse_callback(GLFWwindow *window, double xpos, double ypos)
 {
@@ -591,10 +1187,12 @@ void mouse_callback(GLFWwindow *window, double xpos, double ypos)
     lastX = (float)xpos;
     lastY = (float)ypos;
     camera.ProcessMouseMovement(xoffset, yoffset);
+    gRedrawRequested = true;
 }
 
 void mouse_button_callback(GLFWwindow *window, int button, int action, int)
 {
+    gRedrawRequested = true;
     if (!gSolar)
         return;
     if (button == GLFW_MOUSE_BUTTON_LEFT && action == GLFW_PRESS)
@@ -617,7 +1215,11 @@ void mouse_button_callback(GLFWwindow *window, int button, int action, int)
     }
 }
 
-void scroll_callback(GLFWwindow *window, double, double yoffset) { camera.ProcessMouseScroll((float)yoffset); }
+void scroll_callback(GLFWwindow *window, double, double yoffset)
+{
+    camera.ProcessMouseScroll((float)yoffset);
+    gRedrawRequested = true;
+}
 
 void processInput(GLFWwindow *window, SolarSystem &solar)
 {
@@ -638,6 +1240,9 @@ void processInput(GLFWwindow *window, SolarSystem &solar)
     else
         tabPressed = false;
 
+    // Slow down near surfaces, speed up in open space
+    camera.ScaleSpeedToClearance(solar.nearestSurfaceDistance(camera.Position));
+
     float cameraSpeed = camera.MovementSpeed;
     if (glfwGetKey(window, GLFW_KEY_LEFT_SHIFT) == GLFW_PRESS)
         cameraSpeed *= 2.0f;
@@ -773,70 +1378,104 @@ void processInput(GLFWwindow *window, SolarSystem &solar)
     }
     else
         mPressed = false;
-}
 
-void generateSphere(unsigned int &VAO, unsigned int &VBO, int &vertexCount, int sectorCount, int stackCount)
-{
-    std::vector<float> vertices;
-    for (int i = 0; i <= stackCount; ++i)
+    // Sphere paths and benchmark sizes by hand; N runs the scripted benchmark
+    static bool iPressed = false, bPressed = false, nPressed = false;
+    if (glfwGetKey(window, GLFW_KEY_I) == GLFW_PRESS)
     {
-        float stackAngle = glm::pi<float>() / 2 - i * glm::pi<float>() / stackCount;
-        float xy = cos(stackAngle);
-        float z = sin(stackAngle);
-
-        for (int j = 0; j <= sectorCount; ++j)
+        if (!iPressed)
         {
-            float sectorAngle = j * 2 * glm::pi<float>() / sectorCount;
-            float x = xy * cos(sectorAngle);
-            float y = xy * sin(sectorAngle);
-
-            vertices.push_back(x);
-            vertices.push_back(y);
-            vertices.push_back(z);
-            vertices.push_back(x);
-            vertices.push_back(y);
-            vertices.push_back(z);
-            vertices.push_back((float)j / sectorCount);
-            vertices.push_back((float)i / stackCount);
+            gSpherePath = (gSpherePath + 1) % SPHERE_PATH_COUNT;
+            if (gSpherePath == SPHERE_PATH_GPU_DRIVEN && !gGpuDrivenAvailable)
+                gSpherePath = SPHERE_PATH_IMPOSTOR;
+            iPressed = true;
         }
     }
-
-    std::vector<unsigned int> indices;
-    for (int i = 0; i < stackCount; ++i)
+    else
+        iPressed = false;
+    if (glfwGetKey(window, GLFW_KEY_N) == GLFW_PRESS)
     {
-        int k1 = i * (sectorCount + 1);
-        int k2 = k1 + sectorCount + 1;
-
-        for (int j = 0; j < sectorCount; ++j, ++k1, ++k2)
+        if (!nPressed)
+        {
+            if (!gBenchmark.running())
+                startBenchmark(solar);
+            nPressed = true;
+        }
+    }
+    else
+        nPressed = false;
+    if (glfwGetKey(window, GLFW_KEY_B) == GLFW_PRESS)
+    {
+        if (!bPressed)
         {
-            indices.push_back(k1);
-            indices.push_back(k2);
-            indices.push_back(k1 + 1);
-            indices.push_back(k1 + 1);
-            indices.push_back(k2);
-            indices.push_back(k2 + 1);
+            gStressStep = (gStressStep + 1) % StressField::STEP_COUNT;
+            bPressed = true;
         }
     }
+    else
+        bPressed = false;
 
-    std::vector<float> expanded;
-    expanded.reserve(indices.size() * 8);
-    for (unsigned int idx : indices)
-        for (int i = 0; i < 8; ++i)
-            expanded.push_back(vertices[idx * 8 + i]);
+    static bool hPressed = false;
+    if (glfwGetKey(window, GLFW_KEY_H) == GLFW_PRESS)
+    {
+        if (!hPressed)
+        {
+            gDebugHud = !gDebugHud;
+            gDebugText.clear(); // filled in on the next refresh
+            hPressed = true;
+        }
+    }
+    else
+        hPressed = false;
 
-    vertexCount = (int)expanded.size() / 8;
+    static bool vPressed = false;
+    if (glfwGetKey(window, GLFW_KEY_V) == GLFW_PRESS)
+    {
+        if (!vPressed)
+        {
+            gDynamicResolution.setEnabled(!gDynamicResolution.enabled());
+            vPressed = true;
+        }
+    }
+    else
+        vPressed = false;
 
-    glGenVertexArrays(1, &VAO);
-    glGenBuffers(1, &VBO);
+    static bool kPressed = false;
+    if (glfwGetKey(window, GLFW_KEY_K) == GLFW_PRESS)
+    {
+        if (!kPressed)
+        {
+            gFrameLimitIdx = (gFrameLimitIdx + 1) % (int)(sizeof(FRAME_LIMITS) / sizeof(FRAME_LIMITS[0]));
+            gFramePacer.setTargetFps(FRAME_LIMITS[gFrameLimitIdx]);
+            // Dynamic resolution aims for the same frame time as the limiter
+            gDynamicResolution.setBudget(gFramePacer.frameBudgetMs());
+            kPressed = true;
+        }
+    }
+    else
+        kPressed = false;
 
-    glBindVertexArray(VAO);
-    glBindBuffer(GL_ARRAY_BUFFER, VBO);
-    glBufferData(GL_ARRAY_BUFFER, expanded.size() * sizeof(float), expanded.data(), GL_STATIC_DRAW);
+    static bool yPressed = false;
+    if (glfwGetKey(window, GLFW_KEY_Y) == GLFW_PRESS)
+    {
+        if (!yPressed)
+        {
+            gFramePacer.setSwapInterval(gFramePacer.swapInterval() != 0 ? 0 : 1);
+            yPressed = true;
+        }
+    }
+    else
+        yPressed = false;
 
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void *)0);
-    glEnableVertexAttribArray(0);
-    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void *)(3 * sizeof(float)));
-    glEnableVertexAttribArray(1);
-    glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void *)(6 * sizeof(float)));
-    glEnableVertexAttribArray(2);
+    static bool lPressed = false;
+    if (glfwGetKey(window, GLFW_KEY_L) == GLFW_PRESS)
+    {
+        if (!lPressed)
+        {
+            gFramePacer.setLowLatency(!gFramePacer.lowLatency());
+            lPressed = true;
+        }
+    }
+    else
+        lPressed = false;
 }
@@ -3,11 +3,11 @@
 layout(location = 0) in vec3 aPos;   // Position of the asteroid/particle
 
 uniform mat4 model;
-uniform mat4 view;
-uniform mat4 projection;
+
+// Camera and Lighting blocks and SceneDepth() come from FrameUniforms::prelude()
 
 void main()
 {
-    gl_Position = projection * view * model * vec4(aPos, 1.0);
+    gl_Position = SceneDepth(projection * view * model * vec4(aPos, 1.0));
     gl_PointSize = 3.0; // Size of each particle point
 }
\ No newline at end of file
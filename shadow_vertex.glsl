@@ -3,12 +3,23 @@
 // Vertex position input
 layout (location = 0) in vec3 aPos;
 
-// Uniforms for light-space transformations
-uniform mat4 lightSpaceMatrix;
-uniform mat4 model;
+// Per-instance sphere data (see SphereBatch)
+layout (location = 3) in mat4 aModel;
+layout (location = 7) in vec4 aParams;
+
+// The Lighting block (light-space transform) comes from FrameUniforms::prelude()
+
+const int SPHERE_SKY = 2;
 
 void main()
 {
+    // The star sphere never casts: park it outside the clip volume
+    if ((int(aParams.y) & SPHERE_SKY) != 0)
+    {
+        gl_Position = vec4(2.0, 2.0, 2.0, 1.0);
+        return;
+    }
+
     // Transform the vertex position to the light's perspective
-    gl_Position = lightSpaceMatrix * model * vec4(aPos, 1.0);
+    gl_Position = lightSpaceMatrix * aModel * vec4(aPos, 1.0);
 }
@@ -0,0 +1,10 @@
+#version 330 core
+out vec4 FragColor;
+
+in vec3 Brightness;
+
+void main()
+{
+    // Added onto the scene (see RENDER_PASS_BLENDED)
+    FragColor = vec4(Brightness, 1.0);
+}
@@ -0,0 +1,46 @@
+#version 330 core
+// Sub-pixel bodies as point sprites (see SpriteBatch)
+layout (location = 0) in vec4 aCenter;   // xyz position, w radius
+layout (location = 1) in vec4 aParams;   // x = texture layer, y = flags
+
+out vec3 Brightness;           // Light per pixel of the point
+
+uniform sampler2DArray textureLayers; // One layer per body texture
+uniform float pixelScale;             // Camera::getPixelScale
+
+// Camera and Lighting blocks and SceneDepth() come from FrameUniforms::prelude()
+
+const int SPHERE_EMISSIVE = 1;
+const int SPHERE_UNTEXTURED = 4;
+const float PI = 3.14159265;
+
+void main()
+{
+    vec3 center = aCenter.xyz;
+    int flags = int(aParams.y);
+
+    // The last mip level is the mean color of the texture: the body's albedo
+    vec3 albedo = ((flags & SPHERE_UNTEXTURED) != 0) ? vec3(1.0)
+                                                     : textureLod(textureLayers, vec3(0.5, 0.5, aParams.x), 16.0).rgb;
+
+    // Average over the disc of what fragment.glsl would shade: the emissive
+    // color, or ambient plus Lambert diffuse, where a fully lit disc averages
+    // 2/3 and the Lambert phase function scales that with the phase angle
+    vec3 disc = albedo;
+    if ((flags & SPHERE_EMISSIVE) == 0)
+    {
+        vec3 toSun = normalize(lightPos - center);
+        vec3 toEye = normalize(viewPos - center);
+        float phaseAngle = acos(clamp(dot(toSun, toEye), -1.0, 1.0));
+        float phase = (sin(phaseAngle) + (PI - phaseAngle) * cos(phaseAngle)) / PI;
+        disc = albedo * (0.2 + 2.0 / 3.0 * phase);
+    }
+
+    // Spread the light of the whole disc over the pixels the point covers
+    float radiusPx = aCenter.w / max(length(viewPos - center), 1e-6) * pixelScale;
+    float size = max(2.0 * radiusPx, 1.0);
+    Brightness = disc * (PI * radiusPx * radiusPx) / (size * size);
+    gl_PointSize = size;
+
+    gl_Position = SceneDepth(projection * view * vec4(center, 1.0));
+}
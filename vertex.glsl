@@ -1,32 +1,110 @@
 #version 330 core
+// Permutations (see ShaderPermutations): SHADOWS, ATMOSPHERE, EMISSIVE, INSTANCED, IMPOSTOR
 layout (location = 0) in vec3 aPos;
 layout (location = 1) in vec3 aNormal;
 layout (location = 2) in vec2 aTexCoords;
+#ifdef INSTANCED
+layout (location = 3) in mat4 aModel;    // Per instance (locations 3-6)
+layout (location = 7) in vec4 aParams;   // Per instance: x = texture layer, y = flags
+layout (location = 8) in mat3 aNormalMatrix; // Per instance (locations 8-10), see TransformBatch
+#endif
 
 out vec3 FragPos;              // Position of the fragment in world space
-out vec3 Normal;               // Normal for lighting
+#ifdef IMPOSTOR
+// The fragment shader ray-casts the sphere behind each pixel of the quad
+flat out vec3 Center;          // Sphere center
+flat out float Radius;         // Sphere radius
+flat out mat3 WorldToLocal;    // inverse(mat3(model)): mesh-space point for texture coordinates
+#else
 out vec2 TexCoords;            // Texture coordinates
+#ifndef EMISSIVE
+out vec3 Normal;               // Normal for lighting
+#endif
+#ifdef SHADOWS
 out vec4 FragPosLightSpace;    // Position in light space for shadows
-
+#endif
+#endif
+#ifdef INSTANCED
+flat out float Layer;          // Texture array layer
+flat out int Flags;            // SphereFlags
+#else
 uniform mat4 model;
-uniform mat4 view;
-uniform mat4 projection;
-uniform mat4 lightSpaceMatrix;
+uniform mat3 normalMatrix;     // transpose(inverse(mat3(model))), computed on the CPU
+#endif
+
+// Camera and Lighting blocks and SceneDepth() come from FrameUniforms::prelude()
+
+const int SPHERE_SKY = 2;
 
+#ifdef IMPOSTOR
+// Each instance is a 4-vertex triangle strip (corner from gl_VertexID) that
+// covers the sphere's silhouette: a square across the tangent cone from the
+// eye, in the plane through the center. Spheres reaching near the eye (and
+// the sky, which surrounds it) get a full-screen quad instead.
 void main()
 {
+    Layer = aParams.x;
+    Flags = int(aParams.y);
+    Center = aModel[3].xyz;
+    Radius = length(aModel[0].xyz);
+    WorldToLocal = transpose(aNormalMatrix); // = inverse(mat3(model))
+
+    vec2 corner = vec2((gl_VertexID & 1) != 0 ? 1.0 : -1.0, (gl_VertexID & 2) != 0 ? 1.0 : -1.0);
+    vec3 toCenter = Center - viewPos;
+    float eyeDistance = length(toCenter);
+    float viewDepth = -(view * vec4(Center, 1.0)).z;
+
+    // Margin so no corner of the tilted quad can reach the near plane
+    if ((Flags & SPHERE_SKY) != 0 || viewDepth < 3.0 * Radius + 1.0)
+    {
+        // Any point on a plane of constant view depth gives the pixel's ray
+        vec4 world = inverse(projection * view) * vec4(corner, 0.5, 1.0);
+        FragPos = world.xyz / world.w;
+        gl_Position = vec4(corner, depthParams.z, 1.0);
+        return;
+    }
+
+    vec3 axis = toCenter / eyeDistance;
+    vec3 helper = abs(axis.y) < 0.99 ? vec3(0.0, 1.0, 0.0) : vec3(1.0, 0.0, 0.0);
+    vec3 right = normalize(cross(axis, helper));
+    vec3 up = cross(right, axis);
+    float halfSize = Radius * eyeDistance / sqrt(eyeDistance * eyeDistance - Radius * Radius);
+
+    FragPos = Center + (corner.x * right + corner.y * up) * halfSize;
+    gl_Position = projection * view * vec4(FragPos, 1.0);
+}
+#else
+void main()
+{
+#ifdef INSTANCED
+    mat4 model = aModel;
+    mat3 normalMatrix = aNormalMatrix;
+    Layer = aParams.x;
+    Flags = int(aParams.y);
+#endif
+
     // World position of the fragment
     FragPos = vec3(model * vec4(aPos, 1.0));
+    TexCoords = aTexCoords;
 
+#ifndef EMISSIVE
     // Transform normal to world space
-    Normal = mat3(transpose(inverse(model))) * aNormal;
-
-    // Pass texture coordinates
-    TexCoords = aTexCoords;
+    Normal = normalMatrix * aNormal;
+#endif
 
+#ifdef SHADOWS
     // Calculate position relative to the light's projection
     FragPosLightSpace = lightSpaceMatrix * vec4(FragPos, 1.0);
+#endif
 
-    // Final clip space position
-    gl_Position = projection * view * vec4(FragPos, 1.0);
+    vec4 clipPos = projection * view * vec4(FragPos, 1.0);
+
+#ifdef INSTANCED
+    // The sky sits exactly on the far plane so every body draws over it
+    gl_Position = ((Flags & SPHERE_SKY) != 0) ? vec4(clipPos.xy, depthParams.z * clipPos.w, clipPos.w)
+                                               : SceneDepth(clipPos);
+#else
+    gl_Position = SceneDepth(clipPos);
+#endif
 }
+#endif